@@ -0,0 +1,78 @@
+#include <xorai/kernels.h>
+#include <xorai/random.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+/* Compares the accuracy and throughput of each `Accumulation` mode for f32 dot products,
+ * against f64 as the "just use more bits" alternative. The reference is computed in double-double.
+ *
+ * Usage: xorai_bench_accumulation [seed] */
+
+template<typename Float>
+void measure(const char* name, const cvector<Float>& a, const cvector<Float>& b, Accumulation accumulation, fdd reference)
+{
+    using clock = std::chrono::steady_clock;
+
+    const u64 count = a.size();
+    u64 repetitions = 0;
+    Float result = 0.0;
+
+    clock::time_point start = clock::now();
+    f64 seconds = 0.0;
+
+    /* Repeat until at least 0.2 seconds have passed so that short vectors are timed reliably. */
+    while(seconds < 0.2)
+    {
+        result = inner_product(a.data(), b.data(), count, 1, accumulation);
+        repetitions++;
+
+        seconds = std::chrono::duration<f64>(clock::now() - start).count();
+    }
+
+    f64 error = static_cast<f64>((fdd(static_cast<f64>(result)) - reference) / reference);
+    f64 throughput = static_cast<f64>(count * repetitions) / seconds / 1e9;
+
+    std::cout << std::setw(14) << name
+              << std::setw(14) << std::scientific << std::setprecision(2) << (error < 0 ? -error : error)
+              << std::setw(14) << std::fixed << std::setprecision(3) << throughput
+              << std::setw(14) << std::setprecision(2) << throughput * 2 * sizeof(Float) << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    u64 seed = argc > 1 ? std::stoull(argv[1]) : 42;
+    Philox generator(seed);
+
+    for(u64 count : {1000ul, 99999ul, 1000000ul, 10000000ul})
+    {
+        cvector<f32> a(count), b(count);
+        cvector<f64> a64(count), b64(count);
+        cvector<fdd> ad(count), bd(count);
+
+        /* Positive values, as in a wide layer of sigmoid activations, make the naive error grow with length. */
+        for(u64 i = 0; i < count; i++)
+        {
+            a[i] = static_cast<f32>(generator.uniform(2 * i));
+            b[i] = static_cast<f32>(generator.uniform(2 * i + 1));
+
+            a64[i] = a[i];
+            b64[i] = b[i];
+            ad[i] = a64[i];
+            bd[i] = b64[i];
+        }
+
+        fdd reference = fdd::dot(ad.data(), bd.data(), count, 1);
+
+        std::cout << "\nlength " << count << "\n";
+        std::cout << std::setw(14) << "mode" << std::setw(14) << "rel. error"
+                  << std::setw(14) << "Gelem/s" << std::setw(14) << "GB/s" << "\n";
+
+        measure("f32 naive", a, b, Accumulation::Naive, reference);
+        measure("f32 pairwise", a, b, Accumulation::Pairwise, reference);
+        measure("f32 kahan", a, b, Accumulation::Kahan, reference);
+        measure("f64 naive", a64, b64, Accumulation::Naive, reference);
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
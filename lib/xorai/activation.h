@@ -4,6 +4,24 @@
 
 #include <xorai/types.h>
 
+/* Activation function of a layer. Each one has a derivative that only depends on the
+ * layer's outputs, so the backward pass never needs the pre-activation values.
+ *   - Sigmoid:   1 / (1 + e^-x), the original activation.
+ *   - ReLU:      max(x, 0).
+ *   - LeakyReLU: x for x > 0, otherwise LEAKY_RELU_SLOPE * x.
+ *   - Tanh:      tanh(x).
+ *   - Identity:  x, e.g. for regression outputs. */
+enum class Activation : u8
+{
+    Sigmoid,
+    ReLU,
+    LeakyReLU,
+    Tanh,
+    Identity
+};
+
+using ActivationArray = cvector<Activation>;
+
 template<typename Float>
 Float Exp(Float);
 
@@ -13,4 +31,19 @@ Float sigmoid(Float);
 template<typename Float>
 Float derivative(Float);
 
-#endif //XORAI_ACTIVATION_H
\ No newline at end of file
+/* Applies `activation` to `count` values in place. */
+template<typename Float>
+void activate(Activation, Float*, u64);
+
+/* Adds `biases[r]` to row `r` of a `rows` x `cols` matrix and applies `activation`, in one pass. */
+template<typename Float>
+void activate(Activation, Float*, const Float*, u64, u64);
+
+/* Multiplies each of `count` errors by the derivative of `activation` at the matching output. */
+template<typename Float>
+void apply_derivative(Activation, const Float*, Float*, u64);
+
+const char* activation_name(Activation);
+Activation parse_activation(const std::string&);
+
+#endif //XORAI_ACTIVATION_H
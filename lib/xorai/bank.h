@@ -0,0 +1,49 @@
+#pragma once
+#ifndef XORAI_BANK_H
+#define XORAI_BANK_H
+
+#include <xorai/network.h>
+
+/* Trains many networks of the same topology at once, e.g. for hyperparameter sweeps and ensembles.
+ * Every parameter is stored model-minor (structure of arrays): element (r, c) of a layer's weights
+ * is followed by the same element of every other model, so the innermost loop of each step runs
+ * across models and vectorizes even when the layers themselves are tiny.
+ *
+ * Model `m` makes the per-sample updates `Network::train` would make with `learning_rates[m]` and `seeds[m]`,
+ * equal up to floating-point rounding: `Network` sums wide layers in several lanes, the bank in order, so the
+ * last bits can differ and drift apart over training. `network(m)` turns it back into a regular `Network`. */
+template<typename Float>
+class ModelBank
+{
+private:
+    using matrix_t = Matrix<Float>;
+
+public:
+    ModelBank(const U64Array&, const cvector<Float>&, const U64Array&, Initializer = Initializer::Uniform);
+
+    void train(Dataset<Float>&, Dataset<Float>&, u64);
+    matrix_t predict(const cvector<Float>&) const;
+    Network<Float> network(u64) const;
+    void save(u64, std::string, i8 = 8) const;
+    u64 size() const;
+
+    U64Array layers;
+    cvector<Float> learning_rates;
+    U64Array seeds;
+    ActivationArray activations;        // Shared by every model, sigmoid unless changed.
+
+    /* `weights[i][(r * layers[i] + c) * size() + m]` and `biases[i][r * size() + m]`. */
+    cvector<cvector<Float>> weights;
+    cvector<cvector<Float>> biases;
+
+private:
+    void feed_forward(const cvector<Float>&);
+    void back_propagate(const cvector<Float>&);
+
+    /* `neurons[i][r * size() + m]` holds the output of neuron `r` of layer `i` for model `m`. */
+    cvector<cvector<Float>> neurons;
+    cvector<cvector<Float>> errors;
+    cvector<Float> gradients;
+};
+
+#endif //XORAI_BANK_H
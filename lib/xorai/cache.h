@@ -0,0 +1,97 @@
+#pragma once
+#ifndef XORAI_CACHE_H
+#define XORAI_CACHE_H
+
+#include <xorai/matrix.h>
+#include <unordered_map>
+#include <string_view>
+#include <atomic>
+#include <mutex>
+#include <list>
+
+/* Identifies the weights of a network. Every new version is unique in the process, so networks that share a cache
+ * never mistake each other's results. Copies keep the version (a copy has the same weights) and, like `SharedMutex`,
+ * leave the owning class copyable; updates are atomic, since pipeline stages update their layers concurrently. */
+class WeightsVersion
+{
+public:
+    WeightsVersion() : value(fresh()) {}
+    WeightsVersion(const WeightsVersion& other) : value(other.value.load(std::memory_order_relaxed)) {}
+
+    WeightsVersion& operator=(const WeightsVersion& other)
+    {
+        this->value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    operator u64() const { return this->value.load(std::memory_order_relaxed); }
+    void next() { this->value.store(fresh(), std::memory_order_relaxed); }
+
+private:
+    static u64 fresh()
+    {
+        static std::atomic<u64> versions(0);
+        return versions.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<u64> value;
+};
+
+/* Counters of an `InferenceCache` since it was created or last cleared. */
+struct CacheStats
+{
+    u64 hits;
+    u64 misses;
+    u64 stale;          // Misses on a result of other weights, which are dropped.
+    u64 evictions;
+    u64 entries;
+
+    f64 hit_rate() const
+    {
+        return this->hits + this->misses ? static_cast<f64>(this->hits) / static_cast<f64>(this->hits + this->misses) : 0.0;
+    }
+};
+
+/* A bounded map from the exact bits of an input (its values, never their padding) to the result computed for it,
+ * split into shards that each have their own lock and evict their least recently used entry when full. Every result
+ * is tagged with the version of the weights that produced it and only returned for that version, so training never
+ * has to clear the cache: results of old weights miss, and are dropped when found or evicted when space is needed. */
+template<typename Float>
+class InferenceCache
+{
+private:
+    using matrix_t = Matrix<Float>;
+
+public:
+    explicit InferenceCache(u64, u64 = 16);
+
+    bool find(u64, const Float*, u64, matrix_t&);
+    void insert(u64, const Float*, u64, const matrix_t&);
+    void clear();
+    CacheStats stats() const;
+
+    const u64 capacity;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        u64 version;
+        matrix_t result;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex lock;
+        std::list<Entry> order;     // Most recently used first.
+        std::unordered_map<std::string_view, typename std::list<Entry>::iterator> index;
+        u64 hits = 0, misses = 0, stale = 0, evictions = 0;
+    };
+
+    Shard& shard(std::string_view);
+
+    cvector<Shard> shards;
+    u64 shard_capacity;
+};
+
+#endif //XORAI_CACHE_H
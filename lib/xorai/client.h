@@ -0,0 +1,26 @@
+#pragma once
+#ifndef XORAI_CLIENT_H
+#define XORAI_CLIENT_H
+
+#include <xorai/protocol.h>
+#include <string>
+
+/* A blocking client for `xorai_serve`. One client owns one connection
+ * and is meant to be used from a single thread at a time. */
+class Client
+{
+public:
+    explicit Client(const std::string&);
+    ~Client();
+
+    F64Array infer(const F64Array&);
+    ServerStats stats();
+
+private:
+    F64Array request(Opcode, const F64Array&);
+
+    i32 fd;
+    u32 next_id;
+};
+
+#endif //XORAI_CLIENT_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef XORAI_COMPRESS_H
+#define XORAI_COMPRESS_H
+
+#include <xorai/types.h>
+#include <string>
+
+/* Lossless compression of arrays of fixed-width values, such as the weights of a model:
+ *   1. Each value is XORed with a prediction of it: the value before it, or the same value of a base array
+ *      (the model a checkpoint was trained from), so that the bits they share become zeros. Blocks where
+ *      the prediction does not pay off are left as they are.
+ *   2. The bytes are shuffled into planes (byte 0 of every value, then byte 1, ...), which groups the
+ *      mostly-zero sign and exponent bytes apart from the noisy low mantissa bytes.
+ *   3. Each plane is entropy coded with rANS, or stored as is when that does not help.
+ * Values are split into blocks that are coded independently, so both directions run in parallel. */
+
+/* Appends `count` values of `width` bytes to `out`, predicted from `base` (with the same layout) when not null. */
+void compress_values(const char*, const char*, u64, u64, std::string&);
+
+/* Reads `count` values of `width` bytes written by `compress_values` from the `size` bytes at `source` into
+ * `values`, and moves `source` past them. Returns false for malformed input, which is rejected before `values`
+ * is resized, so a corrupt header cannot demand more memory than its payload could describe. */
+bool decompress_values(const char*&, u64, const char*, std::string&, u64, u64);
+
+#endif //XORAI_COMPRESS_H
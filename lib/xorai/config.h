@@ -13,4 +13,11 @@
  * it will be undefined automatically. */
 //#define __F128_SUPPORT__
 
+/* Pruned weight matrices at or below this density use
+ * the sparse (CSR) kernels during inference instead of dense ones. */
+#define SPARSE_DENSITY_THRESHOLD 0.3
+
+/* Slope of `Activation::LeakyReLU` for negative inputs. */
+#define LEAKY_RELU_SLOPE 0.01
+
 #endif //XORAI_CONFIG_H
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#ifndef XORAI_DISTRIBUTED_H
+#define XORAI_DISTRIBUTED_H
+
+#include <xorai/network.h>
+#include <xorai/protocol.h>
+#include <condition_variable>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+/* Data-parallel training across processes: every `Worker` trains on its own shard of the data and
+ * streams its weight updates to one `ParameterServer`, which owns the authoritative network.
+ *
+ * Addresses are either Unix-domain socket paths (anything containing a `/`) or TCP `host:port` pairs.
+ * Messages use the host byte order and carry raw `Float` values, so every process of a job must be
+ * the same build on machines of the same architecture.
+ *
+ *   Message: u8 op | u8 width | u32 layer | u64 count | u64 version | u64 clock | u64 staleness | count x Float
+ *
+ *   Hello       worker -> server  Joins the job.
+ *   Parameters  server -> worker  Every layer's weights then biases. `version` counts the server's updates,
+ *                                 `clock` the worker's steps they include, `staleness` the job's bound.
+ *   Delta       worker -> server  The change one step made to the weights then biases of `layer`.
+ *   Commit      worker -> server  Ends a step, after the deltas of all its layers.
+ *   Bye         worker -> server  Leaves the job. */
+enum class ParameterOp : u8
+{
+    Hello = 0,
+    Parameters = 1,
+    Delta = 2,
+    Commit = 3,
+    Bye = 4
+};
+
+#pragma pack(push, 1)
+struct ParameterHeader
+{
+    ParameterOp op;
+    u8 width;           // sizeof(Float) of the sender.
+    u32 layer;
+    u64 count;
+    u64 version;
+    u64 clock;
+    u64 staleness;
+};
+#pragma pack(pop)
+
+i32 listen_socket(const std::string&);
+i32 connect_socket(const std::string&);
+
+/* Serves the parameters of `network` to a fixed number of workers until all of them have left.
+ *   - staleness == 0: synchronous. Each step sums the deltas of every worker and applies them at once,
+ *                     like one mini-batch the size of all workers' batches together (hidden layers differ
+ *                     slightly, since each worker backpropagates through weights only it has updated).
+ *   - staleness > 0:  asynchronous. Each worker's step is applied as soon as it is committed, and a worker
+ *                     may run at most `staleness` steps ahead of the slowest one (stale synchronous parallel). */
+template<typename Float>
+class ParameterServer
+{
+private:
+    struct Connection
+    {
+        explicit Connection(i32 fd) : fd(fd) {}
+        ~Connection() { ::close(this->fd); }
+
+        const i32 fd;
+        std::mutex write_lock;
+        cvector<Float> delta;       // Deltas of the current step (asynchronous mode only).
+        u64 clock = 0;              // Steps committed.
+        bool active = true;
+        bool committed = false;     // Waiting for the others to finish the step (synchronous mode).
+        bool deferred = false;      // Too far ahead; answered once the slowest worker catches up.
+    };
+
+    /* Replies are built under the state lock and sent after it is released. */
+    struct Reply
+    {
+        Connection* connection;
+        cvector<u8> message;
+    };
+
+public:
+    ParameterServer(Network<Float>&, std::string, u64, u64 = 0);
+    ~ParameterServer();
+
+    void run();
+
+    const std::string address;
+    const u64 workers;
+    const u64 staleness;
+    u64 version;        // Updates applied to the network.
+
+private:
+    void serve_connection(Connection&);
+    void commit(Connection&, cvector<Reply>&);
+    void leave(Connection&, cvector<Reply>&);
+    void apply(cvector<Float>&);
+    void release(cvector<Reply>&);
+    cvector<u8> parameters(const Connection&) const;
+
+    Network<Float>& network;
+    cvector<u64> offsets;   // Start of each layer's weights in the flattened parameters.
+
+    i32 listener;
+    std::mutex lock;
+    std::deque<Connection> connections;
+    cvector<Float> sum;     // Deltas of the current synchronous step.
+};
+
+/* One process of a distributed job. Training runs locally on the worker's shard, in mini-batches;
+ * each layer's change is queued for a sender thread as soon as backpropagation has produced it,
+ * so the upload overlaps with the remaining layers and with the next step. */
+template<typename Float>
+class Worker
+{
+private:
+    using matrix_t = Matrix<Float>;
+
+public:
+    Worker(Network<Float>&, const std::string&);
+    ~Worker();
+
+    void train(Dataset<Float>&, Dataset<Float>&, u64, u64 = 1);
+
+    u64 staleness;
+    u64 steps;          // Steps committed.
+    u64 version;        // Server version of the last parameters received.
+
+private:
+    void step(MatrixView<const Float>, MatrixView<const Float>);
+    void receive();
+    void send(ParameterOp, u32 = 0, const Float* = nullptr, u64 = 0);
+    void send_loop();
+
+    Network<Float>& network;
+    cvector<u64> offsets;
+    i32 fd;
+
+    std::deque<cvector<Float>> pending;     // Whole-step deltas the server has not acknowledged yet.
+    cvector<Float> current;                 // Delta of the step being computed.
+
+    std::thread sender;
+    std::mutex queue_lock;
+    std::condition_variable queue_ready;
+    std::deque<cvector<u8>> queue;
+    bool closing;
+};
+
+#endif //XORAI_DISTRIBUTED_H
@@ -0,0 +1,288 @@
+#pragma once
+#ifndef XORAI_DOUBLE_DOUBLE_H
+#define XORAI_DOUBLE_DOUBLE_H
+
+#include <string>
+#include <cmath>
+
+/* An unevaluated sum of two doubles (hi + lo, with |lo| <= ulp(hi) / 2) giving a ~106-bit mantissa.
+ * Every operation is built from hardware f64 arithmetic and fused multiply-adds,
+ * following the algorithms of Dekker, Knuth and the QD library (Hida, Li and Bailey).
+ * It is a much faster alternative to the software `__float128` for near-quad precision. */
+class DoubleDouble
+{
+public:
+    constexpr DoubleDouble() : hi(0.0), lo(0.0) {}
+    constexpr DoubleDouble(double hi) : hi(hi), lo(0.0) {}
+    constexpr DoubleDouble(double hi, double lo) : hi(hi), lo(lo) {}
+
+    explicit constexpr operator double() const { return this->hi; }
+    explicit constexpr operator float() const { return static_cast<float>(this->hi); }
+    explicit constexpr operator long double() const
+    {
+        return static_cast<long double>(this->hi) + static_cast<long double>(this->lo);
+    }
+
+    /* Exact sum of two doubles as (sum, error). */
+    static DoubleDouble two_sum(double a, double b)
+    {
+        double s = a + b;
+        double v = s - a;
+        return {s, (a - (s - v)) + (b - v)};
+    }
+
+    /* Exact sum when |a| >= |b|. */
+    static DoubleDouble quick_two_sum(double a, double b)
+    {
+        double s = a + b;
+        return {s, b - (s - a)};
+    }
+
+    /* Exact product of two doubles as (product, error). */
+    static DoubleDouble two_prod(double a, double b)
+    {
+        double p = a * b;
+        return {p, std::fma(a, b, -p)};
+    }
+
+    friend DoubleDouble operator+(const DoubleDouble& a, const DoubleDouble& b)
+    {
+        DoubleDouble s = two_sum(a.hi, b.hi);
+        DoubleDouble t = two_sum(a.lo, b.lo);
+
+        s.lo += t.hi;
+        s = quick_two_sum(s.hi, s.lo);
+        s.lo += t.lo;
+
+        return quick_two_sum(s.hi, s.lo);
+    }
+
+    friend DoubleDouble operator-(const DoubleDouble& a)
+    {
+        return {-a.hi, -a.lo};
+    }
+
+    friend DoubleDouble operator-(const DoubleDouble& a, const DoubleDouble& b)
+    {
+        return a + (-b);
+    }
+
+    friend DoubleDouble operator*(const DoubleDouble& a, const DoubleDouble& b)
+    {
+        DoubleDouble p = two_prod(a.hi, b.hi);
+        p.lo += a.hi * b.lo + a.lo * b.hi;
+
+        return quick_two_sum(p.hi, p.lo);
+    }
+
+    friend DoubleDouble operator/(const DoubleDouble& a, const DoubleDouble& b)
+    {
+        double q1 = a.hi / b.hi;
+        DoubleDouble r = a - b * q1;
+
+        double q2 = r.hi / b.hi;
+        r = r - b * q2;
+
+        double q3 = r.hi / b.hi;
+
+        return quick_two_sum(q1, q2) + q3;
+    }
+
+    DoubleDouble& operator+=(const DoubleDouble& other) { return *this = *this + other; }
+    DoubleDouble& operator-=(const DoubleDouble& other) { return *this = *this - other; }
+    DoubleDouble& operator*=(const DoubleDouble& other) { return *this = *this * other; }
+    DoubleDouble& operator/=(const DoubleDouble& other) { return *this = *this / other; }
+
+    friend bool operator==(const DoubleDouble& a, const DoubleDouble& b) { return a.hi == b.hi && a.lo == b.lo; }
+    friend bool operator!=(const DoubleDouble& a, const DoubleDouble& b) { return !(a == b); }
+    friend bool operator<(const DoubleDouble& a, const DoubleDouble& b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+    friend bool operator>(const DoubleDouble& a, const DoubleDouble& b) { return b < a; }
+    friend bool operator<=(const DoubleDouble& a, const DoubleDouble& b) { return !(b < a); }
+    friend bool operator>=(const DoubleDouble& a, const DoubleDouble& b) { return !(a < b); }
+
+    /* Multiplies by 2^exponent, which is exact. */
+    static DoubleDouble ldexp(const DoubleDouble& a, int exponent)
+    {
+        return {std::ldexp(a.hi, exponent), std::ldexp(a.lo, exponent)};
+    }
+
+    static DoubleDouble exp(const DoubleDouble& x)
+    {
+        /* ln(2) to double-double precision. */
+        const DoubleDouble ln2(6.931471805599452862e-01, 2.319046813846299558e-17);
+
+        if(x.hi > 709.78)
+            return {HUGE_VAL, 0.0};
+        if(x.hi < -745.2)
+            return {0.0, 0.0};
+
+        /* Reduce to x = k * ln(2) + r with |r| <= ln(2) / 2, then scale r down by 2^9
+         * so that a short Taylor series of exp(r) - 1 converges to full precision. */
+        double k = std::floor(x.hi / ln2.hi + 0.5);
+        DoubleDouble r = ldexp(x - ln2 * k, -9);
+
+        DoubleDouble term = r;
+        DoubleDouble sum = r;
+
+        for(int n = 2; n < 20; n++)
+        {
+            term = term * r / static_cast<double>(n);
+            sum += term;
+
+            if(std::abs(term.hi) < 1e-35 * std::abs(sum.hi))
+                break;
+        }
+
+        /* Undo the scaling: (1 + s)^2 - 1 = 2s + s^2, applied 9 times. */
+        for(int n = 0; n < 9; n++)
+            sum = ldexp(sum, 1) + sum * sum;
+
+        return ldexp(sum + 1.0, static_cast<int>(k));
+    }
+
+    /* Compensated dot product of `count` elements, reading `b` with the given stride.
+     * Products are split exactly and the running sum tracks its rounding error in a double,
+     * which is cheaper than a full double-double addition per term. */
+    static DoubleDouble dot(const DoubleDouble* a, const DoubleDouble* b, unsigned long count, unsigned long stride)
+    {
+        double sum = 0.0, error = 0.0;
+
+        for(unsigned long k = 0; k < count; k++)
+        {
+            const DoubleDouble& x = a[k];
+            const DoubleDouble& y = b[k * stride];
+
+            DoubleDouble p = two_prod(x.hi, y.hi);
+            DoubleDouble s = two_sum(sum, p.hi);
+
+            sum = s.hi;
+            error += s.lo + p.lo + (x.hi * y.lo + x.lo * y.hi);
+        }
+
+        return quick_two_sum(sum, error);
+    }
+
+    /* Formats in scientific notation with `digits` significant digits (at most 34). */
+    std::string to_string(int digits) const
+    {
+        if(std::isnan(this->hi))
+            return "nan";
+        if(std::isinf(this->hi))
+            return this->hi < 0 ? "-inf" : "inf";
+        if(this->hi == 0.0)
+            return "0";
+
+        digits = digits < 1 ? 1 : (digits > 34 ? 34 : digits);
+
+        DoubleDouble x = this->hi < 0 ? -*this : *this;
+        int exponent = static_cast<int>(std::floor(std::log10(x.hi)));
+
+        x = x / power_of_ten(exponent);
+
+        /* log10 can be off by one near powers of ten. */
+        if(x.hi >= 10.0)
+        {
+            x = x / 10.0;
+            exponent++;
+        }
+        else if(x.hi < 1.0)
+        {
+            x = x * 10.0;
+            exponent--;
+        }
+
+        std::string mantissa;
+
+        for(int i = 0; i <= digits; i++)
+        {
+            int digit = static_cast<int>(std::floor(x.hi));
+            digit = digit < 0 ? 0 : (digit > 9 ? 9 : digit);
+
+            mantissa.push_back(static_cast<char>('0' + digit));
+            x = (x - static_cast<double>(digit)) * 10.0;
+        }
+
+        /* Round on the extra digit, carrying towards the front. */
+        bool carry = mantissa.back() >= '5';
+        mantissa.pop_back();
+
+        for(int i = digits - 1; carry && i >= 0; i--)
+        {
+            carry = mantissa[i] == '9';
+            mantissa[i] = carry ? '0' : static_cast<char>(mantissa[i] + 1);
+        }
+
+        if(carry)
+        {
+            mantissa.insert(mantissa.begin(), '1');
+            mantissa.pop_back();
+            exponent++;
+        }
+
+        std::string output = this->hi < 0 ? "-" : "";
+        output += mantissa.substr(0, 1);
+
+        if(digits > 1)
+            output += "." + mantissa.substr(1);
+
+        return output + "e" + std::to_string(exponent);
+    }
+
+    /* Parses a decimal number such as `-1.25`, `3e-5` or `0.1234567890123456789012345678901`. */
+    static DoubleDouble parse(const std::string& text)
+    {
+        DoubleDouble value;
+        unsigned long i = 0;
+        bool negative = false;
+        int exponent = 0;
+
+        if(i < text.size() && (text[i] == '-' || text[i] == '+'))
+            negative = text[i++] == '-';
+
+        if(text.compare(i, 3, "inf") == 0)
+            return {negative ? -HUGE_VAL : HUGE_VAL, 0.0};
+        if(text.compare(i, 3, "nan") == 0)
+            return {std::nan(""), 0.0};
+
+        for(bool fraction = false; i < text.size(); i++)
+        {
+            if(text[i] == '.')
+                fraction = true;
+            else if(text[i] >= '0' && text[i] <= '9')
+            {
+                value = value * 10.0 + static_cast<double>(text[i] - '0');
+                exponent -= fraction;
+            }
+            else
+                break;
+        }
+
+        if(i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+            exponent += std::stoi(text.substr(i + 1));
+
+        value = exponent < 0 ? value / power_of_ten(-exponent) : value * power_of_ten(exponent);
+        return negative ? -value : value;
+    }
+
+    double hi;
+    double lo;
+
+private:
+    static DoubleDouble power_of_ten(int exponent)
+    {
+        DoubleDouble result(1.0), base(10.0);
+        bool negative = exponent < 0;
+
+        for(unsigned int n = negative ? -exponent : exponent; n; n >>= 1)
+        {
+            if(n & 1)
+                result = result * base;
+
+            base = base * base;
+        }
+
+        return negative ? DoubleDouble(1.0) / result : result;
+    }
+};
+
+#endif //XORAI_DOUBLE_DOUBLE_H
\ No newline at end of file
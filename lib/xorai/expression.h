@@ -0,0 +1,179 @@
+#pragma once
+#ifndef XORAI_EXPRESSION_H
+#define XORAI_EXPRESSION_H
+
+#include <xorai/types.h>
+#include <cassert>
+
+/* Lazy element-wise expressions over matrices.
+ * Chains such as `map(a + b * c, sigmoid<Float>)` only record their operands,
+ * and are evaluated in a single loop once they are assigned to a Matrix. */
+template<typename E>
+class Expression
+{
+public:
+    const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+};
+
+template<typename E>
+concept expression = std::is_base_of_v<Expression<E>, E>;
+
+/* Matrices (the leaves) are held by reference, intermediate nodes by value. */
+template<typename E>
+using ExpressionOperand = std::conditional_t<E::is_leaf, const E&, const E>;
+
+struct ExpressionAdd
+{
+    template<typename Float>
+    static Float apply(Float a, Float b) { return a + b; }
+};
+
+struct ExpressionSub
+{
+    template<typename Float>
+    static Float apply(Float a, Float b) { return a - b; }
+};
+
+struct ExpressionMul
+{
+    template<typename Float>
+    static Float apply(Float a, Float b) { return a * b; }
+};
+
+template<typename L, typename R, typename Op>
+class BinaryExpression : public Expression<BinaryExpression<L, R, Op>>
+{
+public:
+    using value_type = typename L::value_type;
+    static constexpr bool is_leaf = false;
+
+    BinaryExpression(const L& lhs, const R& rhs)
+        : lhs(lhs), rhs(rhs), rows(lhs.rows), cols(lhs.cols)
+    {
+        assert(lhs.rows == rhs.rows && lhs.cols == rhs.cols);
+    }
+
+    value_type operator[](u64 i) const
+    {
+        return Op::apply(this->lhs[i], this->rhs[i]);
+    }
+
+    ExpressionOperand<L> lhs;
+    ExpressionOperand<R> rhs;
+    const u64 rows;
+    const u64 cols;
+};
+
+template<typename E>
+class ScaleExpression : public Expression<ScaleExpression<E>>
+{
+public:
+    using value_type = typename E::value_type;
+    static constexpr bool is_leaf = false;
+
+    ScaleExpression(const E& operand, value_type factor)
+        : operand(operand), factor(factor), rows(operand.rows), cols(operand.cols) {}
+
+    value_type operator[](u64 i) const
+    {
+        return this->operand[i] * this->factor;
+    }
+
+    ExpressionOperand<E> operand;
+    const value_type factor;
+    const u64 rows;
+    const u64 cols;
+};
+
+template<typename E, typename Function>
+class MapExpression : public Expression<MapExpression<E, Function>>
+{
+public:
+    using value_type = typename E::value_type;
+    static constexpr bool is_leaf = false;
+
+    MapExpression(const E& operand, Function func)
+        : operand(operand), func(func), rows(operand.rows), cols(operand.cols) {}
+
+    value_type operator[](u64 i) const
+    {
+        return this->func(this->operand[i]);
+    }
+
+    ExpressionOperand<E> operand;
+    const Function func;
+    const u64 rows;
+    const u64 cols;
+};
+
+/* Repeats a column vector across `cols` columns, e.g. to add a bias to every sample of a batch. */
+template<typename E>
+class BroadcastExpression : public Expression<BroadcastExpression<E>>
+{
+public:
+    using value_type = typename E::value_type;
+    static constexpr bool is_leaf = false;
+
+    BroadcastExpression(const E& operand, u64 cols)
+        : operand(operand), rows(operand.rows), cols(cols)
+    {
+        assert(operand.cols == 1);
+    }
+
+    value_type operator[](u64 i) const
+    {
+        return this->cols == 1 ? this->operand[i] : this->operand[i / this->cols];
+    }
+
+    ExpressionOperand<E> operand;
+    const u64 rows;
+    const u64 cols;
+};
+
+template<expression L, expression R>
+BinaryExpression<L, R, ExpressionAdd> operator+(const L& lhs, const R& rhs)
+{
+    return {lhs, rhs};
+}
+
+template<expression L, expression R>
+BinaryExpression<L, R, ExpressionSub> operator-(const L& lhs, const R& rhs)
+{
+    return {lhs, rhs};
+}
+
+/* Element-wise (Hadamard) product, the lazy counterpart of `Matrix::mul`. */
+template<expression L, expression R>
+BinaryExpression<L, R, ExpressionMul> operator*(const L& lhs, const R& rhs)
+{
+    return {lhs, rhs};
+}
+
+template<expression E>
+ScaleExpression<E> operator*(const E& operand, typename E::value_type factor)
+{
+    return {operand, factor};
+}
+
+template<expression E>
+ScaleExpression<E> operator*(typename E::value_type factor, const E& operand)
+{
+    return {operand, factor};
+}
+
+template<expression E>
+BroadcastExpression<E> broadcast(const E& operand, u64 cols)
+{
+    return {operand, cols};
+}
+
+template<expression E, typename Function>
+MapExpression<E, Function> map(const E& operand, Function func)
+{
+    return {operand, func};
+}
+
+#endif //XORAI_EXPRESSION_H
\ No newline at end of file
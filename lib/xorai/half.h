@@ -0,0 +1,121 @@
+#pragma once
+#ifndef XORAI_HALF_H
+#define XORAI_HALF_H
+
+#include <xorai/types.h>
+#include <cstring>
+
+/* 16-bit storage formats. Neither does arithmetic: values are widened to f32 to be used and narrowed
+ * (rounding to nearest, ties to even) to be stored.
+ *   - f16:  IEEE binary16, 5 exponent and 10 mantissa bits (about 3 decimal digits, |x| <= 65504).
+ *   - bf16: bfloat16, the upper half of an f32 (8 exponent and 7 mantissa bits, the range of f32). */
+struct f16
+{
+    f16() = default;
+    explicit f16(f32 value) : bits(narrow(value)) {}
+
+    explicit operator f32() const
+    {
+        /* Shifted into place, scaling by 2^112 rebiases the exponent of normal and subnormal values alike. */
+        u32 bits = static_cast<u32>(this->bits & 0x7fff) << 13;
+        f32 value;
+
+        std::memcpy(&value, &bits, sizeof(value));
+        value *= 0x1p112f;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        if((this->bits & 0x7c00) == 0x7c00)
+            bits = 0x7f800000 | static_cast<u32>(this->bits & 0x3ff) << 13;
+
+        bits |= static_cast<u32>(this->bits & 0x8000) << 16;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static u16 narrow(f32 value)
+    {
+        u32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const u32 sign = (bits >> 16) & 0x8000;
+        const i32 exponent = static_cast<i32>((bits >> 23) & 0xff) - 112;
+        u32 mantissa = bits & 0x7fffff;
+
+        if(exponent == 143)
+            return static_cast<u16>(sign | 0x7c00 | (mantissa ? 0x200 | (mantissa >> 13) : 0));
+        if(exponent >= 0x1f)
+            return static_cast<u16>(sign | 0x7c00);
+        if(exponent < -10)
+            return static_cast<u16>(sign);
+
+        /* Subnormal results keep the implicit bit and shift further. A carry out of the mantissa
+         * correctly rounds up into the next exponent (or to infinity). */
+        const u32 shift = exponent > 0 ? 13 : static_cast<u32>(14 - exponent);
+        const u32 base = exponent > 0 ? static_cast<u32>(exponent) << 10 : 0;
+
+        mantissa |= exponent > 0 ? 0 : 0x800000;
+
+        u32 half = base | (mantissa >> shift);
+        const u32 rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+
+        if(rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+
+        return static_cast<u16>(sign | half);
+    }
+
+    u16 bits;
+};
+
+struct bf16
+{
+    bf16() = default;
+    explicit bf16(f32 value) : bits(narrow(value)) {}
+
+    explicit operator f32() const
+    {
+        u32 bits = static_cast<u32>(this->bits) << 16;
+        f32 value;
+
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static u16 narrow(f32 value)
+    {
+        u32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        if((bits & 0x7fffffff) > 0x7f800000)
+            return static_cast<u16>((bits >> 16) | 0x40);
+
+        bits += 0x7fff + ((bits >> 16) & 1);
+        return static_cast<u16>(bits >> 16);
+    }
+
+    u16 bits;
+};
+
+/* Decimal places that keep every normal value (MIN) or every value (MAX) of the format when saved as text. */
+#define MIN_F16_PRECISION 4
+#define MAX_F16_PRECISION 8
+
+#define MIN_BF16_PRECISION 4
+#define MAX_BF16_PRECISION MAX_F32_PRECISION
+
+#define INSTANTIATE_CLASS_HALVES(c) \
+    template class c<f16>;          \
+    template class c<bf16>;
+
+/* Converts `count` values between a 16-bit format and f32, with the F16C or AVX-512 BF16 instructions
+ * when the CPU has them. */
+void widen(const f16*, f32*, u64);
+void widen(const bf16*, f32*, u64);
+void narrow(const f32*, f16*, u64);
+void narrow(const f32*, bf16*, u64);
+
+/* Dot product of `count` 16-bit values with `count` f32 values, widening as it loads and summing in f32 lanes. */
+f32 dot(const f16*, const f32*, u64);
+f32 dot(const bf16*, const f32*, u64);
+
+#endif //XORAI_HALF_H
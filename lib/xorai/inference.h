@@ -0,0 +1,117 @@
+#pragma once
+#ifndef XORAI_INFERENCE_H
+#define XORAI_INFERENCE_H
+
+#include <xorai/matrix.h>
+#include <xorai/model.h>
+#include <xorai/half.h>
+#include <xorai/tuner.h>
+
+/* An immutable, inference-only copy of a trained network.
+ * All weights and biases are packed into a single 64-byte aligned allocation
+ * (each layer starting on its own cache line), and no training state is kept. */
+template<typename Float>
+class InferenceModel
+{
+private:
+    using matrix_t = Matrix<Float>;
+
+public:
+    InferenceModel(const U64Array&, const MatrixArray<Float>&, const MatrixArray<Float>&, const ActivationArray&,
+                   Accumulation = Accumulation::Naive);
+    explicit InferenceModel(std::string);
+    InferenceModel(InferenceModel&&) noexcept;
+    InferenceModel(const InferenceModel&) = delete;
+    ~InferenceModel();
+
+    InferenceModel& operator=(InferenceModel&&) noexcept;
+    InferenceModel& operator=(const InferenceModel&) = delete;
+
+    matrix_t predict(const matrix_t&) const;
+    matrix_t test(Float, Float) const;
+    void save(std::string, i8 = 8) const;
+    void tune(KernelTuner&, u64 = 1);
+
+    const Float* weights(u64) const;
+    const Float* biases(u64) const;
+    u64 parameters() const;
+
+    U64Array layers;
+    ActivationArray activations;
+    Accumulation accumulation;
+    cvector<GemmConfig> kernels;        // Matrix product settings per layer, untuned when empty.
+
+private:
+    void pack(const MatrixArray<Float>&, const MatrixArray<Float>&);
+
+    Float* storage;
+    cvector<u64> weight_offsets;
+    cvector<u64> bias_offsets;
+};
+
+/* An inference-only model whose weights and biases are stored in a 16-bit format (`f16` or `bf16`),
+ * which halves the memory and bandwidth of an `f32` model. The dot products widen each weight to f32
+ * in registers as they load it and accumulate every sum in f32. Inputs, activations and outputs are f32. */
+template<typename Half>
+class HalfModel
+{
+public:
+    HalfModel(const U64Array&, const MatrixArray<f32>&, const MatrixArray<f32>&, const ActivationArray&);
+    template<typename Float>
+    explicit HalfModel(const InferenceModel<Float>&);
+    explicit HalfModel(std::string);
+    HalfModel(HalfModel&&) noexcept;
+    HalfModel(const HalfModel&) = delete;
+    ~HalfModel();
+
+    HalfModel& operator=(HalfModel&&) noexcept;
+    HalfModel& operator=(const HalfModel&) = delete;
+
+    Matrix<f32> predict(const Matrix<f32>&) const;
+    Matrix<f32> test(f32, f32) const;
+    void save(std::string, i8 = std::is_same_v<Half, f16> ? MAX_F16_PRECISION : MAX_BF16_PRECISION) const;
+    void save(std::string, Storage) const;
+
+    const Half* weights(u64) const;
+    const Half* biases(u64) const;
+    u64 parameters() const;
+
+    U64Array layers;
+    ActivationArray activations;
+
+private:
+    void pack(const MatrixArray<f32>&, const MatrixArray<f32>&);
+    void multiply(u64, MatrixView<const f32>, MatrixView<f32>) const;
+    Model<f32> unpack() const;
+
+    Half* storage;
+    cvector<u64> weight_offsets;
+    cvector<u64> bias_offsets;
+};
+
+/* Rounds the parameters of `model` to `Half`. */
+template<typename Half>
+template<typename Float>
+HalfModel<Half>::HalfModel(const InferenceModel<Float>& model)
+    : layers(model.layers), activations(model.activations), storage(nullptr)
+{
+    MatrixArray<f32> weights, biases;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+
+        weights.emplace_back(rows, cols);
+        biases.emplace_back(rows, 1);
+
+        for(u64 j = 0; j < rows * cols; j++)
+            weights.back().data[j] = static_cast<f32>(model.weights(i)[j]);
+
+        for(u64 j = 0; j < rows; j++)
+            biases.back().data[j] = static_cast<f32>(model.biases(i)[j]);
+    }
+
+    pack(weights, biases);
+}
+
+#endif //XORAI_INFERENCE_H
\ No newline at end of file
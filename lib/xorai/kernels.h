@@ -0,0 +1,60 @@
+#pragma once
+#ifndef XORAI_KERNELS_H
+#define XORAI_KERNELS_H
+
+#include <xorai/types.h>
+#include <xorai/view.h>
+
+/* How the products of a dot product are summed.
+ *   - Naive:    plain running sums (error grows linearly with the length).
+ *   - Pairwise: sums blocks and then adds the block sums as a tree (error grows logarithmically).
+ *   - Kahan:    Neumaier-compensated sums (error independent of the length, about 4x the additions).
+ * Every mode keeps several independent lanes so that the loops vectorize. */
+enum class Accumulation
+{
+    Naive,
+    Pairwise,
+    Kahan
+};
+
+/* How `gemm` computes a matrix product.
+ *   - InnerProduct: one `inner_product` per element of the result, reading `b` down its columns.
+ *   - Blocked:      rank-1 updates over tiles of `b`, streaming along its rows (Naive accumulation only). */
+enum class GemmStrategy : u8
+{
+    InnerProduct,
+    Blocked
+};
+
+/* A tunable configuration of `gemm`. The defaults reproduce the untuned kernel. */
+struct GemmConfig
+{
+    GemmStrategy strategy = GemmStrategy::InnerProduct;
+    u64 lanes = 8;          // Accumulators of a Naive inner product: 4, 8 or 16.
+    u64 block_k = 64;       // Rows of `b` per tile (Blocked).
+    u64 block_j = 256;      // Columns of `b` per tile (Blocked).
+    u64 threads = 1;        // Threads sharing the rows of the result.
+};
+
+/* Dot product of `count` contiguous elements of `a` with elements of `b` read every `stride` elements. */
+template<typename Float>
+Float inner_product(const Float*, const Float*, u64, u64, Accumulation = Accumulation::Naive);
+
+/* Writes `a * b` to `c` for a `rows` x `inner` matrix `a` and an `inner` x `cols` matrix `b`, all row-major. */
+template<typename Float>
+void gemm(const Float*, const Float*, Float*, u64, u64, u64, Accumulation = Accumulation::Naive, const GemmConfig& = {});
+
+/* Writes `a * b` to `c`. Each view may have its own leading dimension. */
+template<typename Float>
+void gemm(MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>, Accumulation = Accumulation::Naive,
+          const GemmConfig& = {});
+
+/* Writes `aᵀ * b` to `c` without materializing the transpose. */
+template<typename Float>
+void transpose_gemm(MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>);
+
+/* Adds `scale * a * bᵀ` to `c`, for an `m` x `k` matrix `a` and an `n` x `k` matrix `b`. */
+template<typename Float>
+void rank_update(Float, MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>);
+
+#endif //XORAI_KERNELS_H
\ No newline at end of file
@@ -2,51 +2,105 @@
 #ifndef XORAI_MATRIX_H
 #define XORAI_MATRIX_H
 
+#include <xorai/expression.h>
+#include <xorai/kernels.h>
+#include <xorai/storage.h>
 #include <xorai/types.h>
 #include <functional>
 #include <iostream>
 
 template<typename Float>
-class Matrix
+class Matrix : public Expression<Matrix<Float>>
 {
 private:
     typedef cvector<Float> FloatArray;
     typedef Matrix<Float> matrix_t;
 
 public:
-    Matrix(u64, u64, FloatArray&);
+    using value_type = Float;
+    static constexpr bool is_leaf = true;
 
-    matrix_t* add(matrix_t*);
-    matrix_t* sub(matrix_t*);
-    matrix_t* mul(matrix_t*);
-    matrix_t* dot(matrix_t*);
-    matrix_t* map(std::function<Float(Float)>);
-    matrix_t* ref();
-    matrix_t* clone(bool = false) const;
-    matrix_t* transpose();
+    Matrix();
+    Matrix(u64, u64);
+    Matrix(u64, u64, const FloatArray&);
+    explicit Matrix(MatrixView<const Float>);
 
-    static matrix_t* from(const FloatArray&);
-    static matrix_t* random(u64, u64);
-    static void display(matrix_t*);
+    template<typename E>
+    Matrix(const Expression<E>& expression)
+        : rows(0), cols(0)
+    {
+        *this = expression;
+    }
+
+    /* Evaluates a lazy expression chain into this matrix in a single loop. */
+    template<typename E>
+    matrix_t& operator=(const Expression<E>& expression)
+    {
+        const E& source = expression.self();
+
+        this->data.detach();
+
+        if(this->rows * this->cols != source.rows * source.cols)
+            this->data.resize(source.rows * source.cols);
+
+        this->rows = source.rows;
+        this->cols = source.cols;
+
+        Float* output = this->data.data();
+
+        for(u64 i = 0; i < this->rows * this->cols; i++)
+            output[i] = source[i];
+
+        return *this;
+    }
+
+    Float operator[](u64 i) const
+    {
+        return this->data[i];
+    }
+
+    /* The whole matrix as a view; rows are dense, so the stride is `cols`.
+     * A writable view first gives the matrix its own copy of shared storage. */
+    MatrixView<Float> view()
+    {
+        this->data.detach();
+        return MatrixView<Float>(this->data.data(), this->rows, this->cols);
+    }
+
+    MatrixView<const Float> view() const
+    {
+        return MatrixView<const Float>(this->data.data(), this->rows, this->cols);
+    }
+
+    operator MatrixView<const Float>() const
+    {
+        return view();
+    }
+
+    matrix_t& add(const matrix_t&, Float = 1.0);
+    matrix_t& sub(const matrix_t&);
+    matrix_t& mul(const matrix_t&);
+    matrix_t& map(std::function<Float(Float)>);
+    matrix_t& rank_update(Float, MatrixView<const Float>, MatrixView<const Float>);
+    matrix_t dot(MatrixView<const Float>, Accumulation = Accumulation::Naive, const GemmConfig& = {}) const;
+    matrix_t transpose_dot(MatrixView<const Float>) const;
+    matrix_t transpose() const;
+
+    static matrix_t from(const FloatArray&);
+    static matrix_t random(u64, u64, u64, u64 = 0, Float = 0.0, Float = 1.0);
+    static void display(const matrix_t&);
 
     u64 rows;
     u64 cols;
-    FloatArray data;
+    SmallBuffer<Float> data;
 
 private:
-    static void check_destroy(matrix_t*);
     static std::string float_to_string(Float);
-
-    matrix_t* make(FloatArray);
-    matrix_t* make(u64, u64, FloatArray&);
-    static matrix_t* make(u64, u64, FloatArray, bool);
     void assert_float_type();
-
-    bool destroy = false;
 };
 
 
 template<typename Float>
-using MatrixArray = cvector<Matrix<Float>*>;
+using MatrixArray = cvector<Matrix<Float>>;
 
 #endif //XORAI_MATRIX_H
\ No newline at end of file
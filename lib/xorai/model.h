@@ -4,15 +4,52 @@
 
 #include <jsoncpp/json/writer.h>
 #include <jsoncpp/json/reader.h>
+#include <xorai/activation.h>
 #include <xorai/matrix.h>
+#include <xorai/sparse.h>
 #include <fstream>
 
+/* What `Network::save` writes to a model file.
+ *   - Full:      layers, weights, biases and the activations (`d`) of the last sample.
+ *   - Inference: everything except the activations, which only training needs. */
+enum class SaveMode
+{
+    Full,
+    Inference
+};
+
+/* Number format of the values in a binary model file. `Native` is the network's own float type, stored exactly;
+ * the others are converted, so `F16` and `BF16` halve the size of an `f32` model. Every network can load
+ * F16, BF16, F32 and F64 files, while F128 and FDD files only load into networks of that type. */
+enum class Storage : u8
+{
+    F16 = 0,
+    BF16 = 1,
+    F32 = 2,
+    F64 = 3,
+    F128 = 4,
+    FDD = 5,
+    Native = 255
+};
+
+/* How the values of a binary model file are laid out.
+ *   - Plain:      one after another, readable with a plain `memcpy`.
+ *   - Compressed: XOR-predicted, byte-shuffled and entropy coded (see `compress.h`). Lossless, and with a
+ *                 base model (`Network::save_delta`) only the bits that changed since the base take space. */
+enum class Encoding : u8
+{
+    Plain,
+    Compressed
+};
+
 template<typename Float>
 struct Model {
     U64Array layers;
     MatrixArray<Float> data;
     MatrixArray<Float> biases;
     MatrixArray<Float> weights;
+    SparseArray<Float> sparse;
+    ActivationArray activations;
 };
 
 template<typename Float>
@@ -21,28 +58,36 @@ class ModelViewer
 private:
     using matrix_t = Matrix<Float>;
     using MatrixArray_t = MatrixArray<Float>;
+    using sparse_t = SparseMatrix<Float>;
+    using SparseArray_t = SparseArray<Float>;
 
 public:
     explicit ModelViewer(std::string, i8 = 8);
     ~ModelViewer();
 
-    Model<Float>* load();
-    static matrix_t* load(const Json::Value&);
+    Model<Float> load(bool = true);
+    matrix_t load(const Json::Value&) const;
+    sparse_t load_sparse(const Json::Value&) const;
 
     static Json::Value jsonify(const U64Array&);
+    static Json::Value jsonify(const ActivationArray&);
     Json::Value jsonify(const MatrixArray_t&) const;
-    Json::Value jsonify(matrix_t*) const;
+    Json::Value jsonify(const MatrixArray_t&, const SparseArray_t&) const;
+    Json::Value jsonify(const matrix_t&) const;
+    Json::Value jsonify(const sparse_t&) const;
     std::string jsonify(Float) const;
 
     template<typename T>
-    static T parse(const Json::Value&);
+    T parse(const Json::Value&) const;
     void write(const Json::Value&);
+    void write(const Model<Float>&, Storage = Storage::Native, Encoding = Encoding::Plain, const std::string& = "");
 
     const std::string filename;
     const i8 float_precision;
 
 private:
     bool check_root_members();
+    Model<Float> load_binary(const std::string&, bool);
     std::fstream create_file_stream(bool = true);
 
 #ifdef __F128_SUPPORT__
@@ -55,9 +100,19 @@ private:
     static Json::StreamWriter* create_stream_writer();
     static Json::CharReaderBuilder create_reader_builder();
 
+    Json::Value defer(const Float*, u64) const;
+    std::string extract(const std::string&);
+    cvector<Float> numbers(const Json::Value&) const;
+
     Json::StreamWriter* writer;
     std::fstream filestream;
     Json::Value root;
+
+    /* The `d` arrays of a model are formatted and parsed in parallel chunks outside of jsoncpp,
+     * which only sees a marker string in their place. `pending` holds the arrays `jsonify` deferred
+     * until `write` (their matrices must outlive it), `arrays` the ones `load` cut out of the file. */
+    mutable cvector<std::pair<const Float*, u64>> pending;
+    cvector<cvector<Float>> arrays;
 };
 
 #endif //XORAI_MODEL_H
\ No newline at end of file
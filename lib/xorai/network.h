@@ -2,8 +2,35 @@
 #ifndef XORAI_NETWORK_H
 #define XORAI_NETWORK_H
 
+#include <xorai/inference.h>
+#include <xorai/cache.h>
 #include <xorai/matrix.h>
 #include <xorai/model.h>
+#include <xorai/parallel.h>
+#include <xorai/random.h>
+#include <xorai/tuner.h>
+#include <functional>
+#include <iterator>
+#include <memory>
+
+/* Weight initialization schemes for new networks.
+ *   - Uniform: U(0, 1), the original scheme.
+ *   - Xavier:  U(-a, a) with a = sqrt(6 / (fan_in + fan_out)), suited to sigmoid layers.
+ *   - He:      U(-a, a) with a = sqrt(6 / fan_in), suited to ReLU layers. */
+enum class Initializer
+{
+    Uniform,
+    Xavier,
+    He
+};
+
+/* One training example, as consumed by `Network::partial_fit`. */
+template<typename Float>
+struct Sample
+{
+    cvector<Float> inputs;
+    cvector<Float> targets;
+};
 
 template<typename Float>
 class Network
@@ -12,24 +39,100 @@ private:
     using matrix_t = Matrix<Float>;
 
 public:
-    explicit Network(const U64Array&, Float = 0.5);
+    explicit Network(const U64Array&, Float = 0.5, Initializer = Initializer::Uniform, u64 = Philox::entropy());
     explicit Network(std::string, Float = 0.5);
-    ~Network();
+    explicit Network(Model<Float>, Float = 0.5);
 
-    matrix_t* feed_forward(matrix_t*);
-    void back_propagate(matrix_t*, matrix_t*);
+    const matrix_t& feed_forward(const matrix_t&);
+    void back_propagate(const matrix_t&, const matrix_t&);
     void train(Dataset<Float>&, Dataset<Float>&, u64);
-    void save(std::string, i8 = 8) const;
-    matrix_t* test(Float, Float);
+    void partial_fit(const cvector<Float>&, const cvector<Float>&);
+    void partial_fit(MatrixView<const Float>, MatrixView<const Float>);
+    template<std::input_iterator Iterator>
+    u64 partial_fit(Iterator, Iterator, u64 = 1);
+    u64 partial_fit(i32, u64 = 1);
+    void fit_batch(MatrixView<const Float>, MatrixView<const Float>, const std::function<void(u64, bool)>& = nullptr);
+    cvector<bool> checkpoints(u64) const;
+    void save(std::string, i8 = 8, SaveMode = SaveMode::Full) const;
+    void save(std::string, Storage, SaveMode = SaveMode::Full, Encoding = Encoding::Plain) const;
+    void save_delta(std::string, const std::string&, Storage = Storage::Native, SaveMode = SaveMode::Full) const;
+    matrix_t predict(matrix_t) const;
+    matrix_t test(Float, Float) const;
+    matrix_t forward_layer(u64, MatrixView<const Float>) const;
+    matrix_t backward_layer(u64, MatrixView<const Float>, const matrix_t&, const matrix_t&);
+    void prune(Float);
+    void prune_to_sparsity(f64);
+    InferenceModel<Float> freeze() const;
+    Network<Float> fork();
+    void tune(KernelTuner&, u64 = 1);
+    void invalidate();
 
     U64Array layers;
     MatrixArray<Float> data;
     MatrixArray<Float> biases;
     MatrixArray<Float> weights;
+    SparseArray<Float> sparse;
+    ActivationArray activations;        // One per weight layer, sigmoid unless changed.
     Float learning_rate;
+    Accumulation accumulation;
+    cvector<GemmConfig> kernels;        // Matrix product settings per layer, untuned when empty.
+    u64 memory_budget;                  // Bytes of activations a mini-batch step may hold, 0 for no limit.
+    u64 seed;
+
+    /* When set, `predict` and `test` return the stored result of a single sample seen before with the same weights.
+     * `version` identifies the weights and changes whenever training or pruning updates them; call `invalidate`
+     * after changing the weights, activations or kernels in any other way. Copies and forks may share a cache. */
+    std::shared_ptr<InferenceCache<Float>> cache;
+    WeightsVersion version;
+
+    /* Held exclusively by each `partial_fit` update and shared by `predict`, `save` and `freeze`,
+     * so those can run on other threads while the network learns. */
+    mutable SharedMutex guard;
 
 private:
+    Model<Float> snapshot(SaveMode) const;
+    void prune_layer(u64, Float);
+    matrix_t multiply(u64, MatrixView<const Float>) const;
+    bool is_pruned(u64) const;
     void assert_float_type();
 };
 
+/* Trains on the samples of [first, last) as the iterator produces them, `batch` samples per update,
+ * without keeping them. Works with single-pass iterators. Returns the number of samples used. */
+template<typename Float>
+template<std::input_iterator Iterator>
+u64 Network<Float>::partial_fit(Iterator first, Iterator last, u64 batch)
+{
+    batch = std::max<u64>(batch, 1);
+
+    matrix_t inputs(this->layers.front(), batch), targets(this->layers.back(), batch);
+    u64 count = 0, filled = 0;
+
+    for(; first != last; ++first)
+    {
+        const Sample<Float>& sample = *first;
+
+        for(u64 r = 0; r < inputs.rows; r++)
+            inputs.data[r * batch + filled] = sample.inputs[r];
+
+        for(u64 r = 0; r < targets.rows; r++)
+            targets.data[r * batch + filled] = sample.targets[r];
+
+        if(++filled == batch)
+        {
+            partial_fit(inputs, targets);
+            count += batch;
+            filled = 0;
+        }
+    }
+
+    if(filled > 0)
+    {
+        partial_fit(inputs.view().col_range(0, filled), targets.view().col_range(0, filled));
+        count += filled;
+    }
+
+    return count;
+}
+
 #endif //XORAI_NETWORK_H
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef XORAI_PARALLEL_H
+#define XORAI_PARALLEL_H
+
+#include <xorai/types.h>
+#include <shared_mutex>
+#include <algorithm>
+#include <thread>
+
+/* Splits `[0, count)` into contiguous chunks of at least `grain` elements and
+ * calls `func(begin, end)` for each chunk, one chunk per hardware thread.
+ * Small ranges run on the calling thread. */
+template<typename Function>
+void parallel_for(u64 count, u64 grain, Function func)
+{
+    const u64 hardware = std::max(1u, std::thread::hardware_concurrency());
+    const u64 threads = std::min(hardware, (count + grain - 1) / std::max<u64>(grain, 1));
+
+    if(threads <= 1)
+    {
+        func(static_cast<u64>(0), count);
+        return;
+    }
+
+    const u64 chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    for(u64 t = 1; t < threads; t++)
+        workers.emplace_back(func, std::min(count, t * chunk), std::min(count, (t + 1) * chunk));
+
+    func(static_cast<u64>(0), std::min(count, chunk));
+
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+/* A reader-writer lock for members of value types: copies and moves produce a fresh, unlocked mutex
+ * instead of being deleted, so the owning class stays copyable. */
+class SharedMutex : public std::shared_mutex
+{
+public:
+    SharedMutex() = default;
+    SharedMutex(const SharedMutex&) : std::shared_mutex() {}
+    SharedMutex& operator=(const SharedMutex&) { return *this; }
+};
+
+#endif //XORAI_PARALLEL_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef XORAI_PIPELINE_H
+#define XORAI_PIPELINE_H
+
+#include <xorai/network.h>
+#include <xorai/queue.h>
+#include <deque>
+#include <memory>
+#include <thread>
+
+/* Runs a network as a pipeline of stages, each owning a contiguous group of layers and its own thread.
+ * Batches are split into micro-batches of `micro_batch` samples that stream through the stages
+ * over SPSC queues, so every stage works on a different micro-batch at the same time and
+ * only ever touches its own layers' weights.
+ *
+ * Training is asynchronous: a micro-batch's backward pass runs as soon as it reaches the last stage,
+ * so later micro-batches may already see the updates of earlier ones (as in PipeDream).
+ * The network must not be used directly while a pipeline over it exists. */
+template<typename Float>
+class Pipeline
+{
+private:
+    using matrix_t = Matrix<Float>;
+
+    enum class Kind : u8
+    {
+        Predict,
+        Train,
+        Backward,
+        Stop
+    };
+
+    struct Message
+    {
+        Kind kind = Kind::Stop;
+        u64 id = 0;
+        matrix_t values;
+        matrix_t targets;
+        MatrixView<const Float> source;     // Caller's columns a prediction reads in place, instead of `values`.
+    };
+
+    using queue_t = SpscQueue<Message>;
+
+public:
+    Pipeline(Network<Float>&, u64, u64 = 16);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    matrix_t predict(const matrix_t&);
+    void train(Dataset<Float>&, Dataset<Float>&, u64);
+
+    const u64 micro_batch;
+    U64Array boundaries;        // Stage `s` owns the weight layers [boundaries[s], boundaries[s + 1]).
+
+private:
+    void stage_loop(u64);
+    void forward(u64, Message&, std::deque<MatrixArray<Float>>&);
+    void backward(u64, matrix_t, const MatrixArray<Float>&);
+    void send(queue_t&, Message&);
+
+    Network<Float>& network;
+    u64 stages;
+
+    /* Stage `s` reads `forward_queues[s]` and writes its activations to `forward_queues[s + 1]`,
+     * the last of which returns predictions to the caller. Backward passes flow the other way:
+     * stage `s` writes the errors of its inputs to `backward_queues[s]`, read by stage `s - 1`
+     * (or, for stage 0, by the caller as the signal that a training micro-batch has finished). */
+    cvector<std::unique_ptr<queue_t>> forward_queues;
+    cvector<std::unique_ptr<queue_t>> backward_queues;
+    cvector<std::thread> threads;
+};
+
+#endif //XORAI_PIPELINE_H
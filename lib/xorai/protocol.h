@@ -0,0 +1,91 @@
+#pragma once
+#ifndef XORAI_PROTOCOL_H
+#define XORAI_PROTOCOL_H
+
+#include <xorai/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+
+/* Binary protocol spoken by `xorai_serve` over a Unix-domain stream socket.
+ * All fields use the host byte order, since both ends live on the same machine.
+ *
+ *   Request:  u8 opcode | u32 id | u32 count | count x f64 values
+ *   Response: u32 id | u32 count | count x f64 values
+ *
+ * An `Infer` request carries one input sample and is answered with the network's outputs.
+ * A `Stats` request carries no values and is answered with the fields of `ServerStats`. */
+enum class Opcode : u8
+{
+    Infer = 0,
+    Stats = 1
+};
+
+#pragma pack(push, 1)
+struct RequestHeader
+{
+    Opcode opcode;
+    u32 id;
+    u32 count;
+};
+
+struct ResponseHeader
+{
+    u32 id;
+    u32 count;
+};
+#pragma pack(pop)
+
+struct ServerStats
+{
+    f64 requests;
+    f64 batches;
+    f64 mean_batch;
+    f64 p50;            // Latency from arrival to response, in microseconds.
+    f64 p99;
+    f64 throughput;     // Requests per second since the server started.
+};
+
+/* Reads exactly `size` bytes, returning false on EOF or error. */
+inline bool read_exact(i32 fd, void* buffer, u64 size)
+{
+    auto* bytes = static_cast<u8*>(buffer);
+
+    while(size > 0)
+    {
+        ssize_t count = ::read(fd, bytes, size);
+
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            return false;
+
+        bytes += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+/* Writes exactly `size` bytes to a socket, returning false on error (without raising SIGPIPE). */
+inline bool write_exact(i32 fd, const void* buffer, u64 size)
+{
+    auto* bytes = static_cast<const u8*>(buffer);
+
+    while(size > 0)
+    {
+        ssize_t count = ::send(fd, bytes, size, MSG_NOSIGNAL);
+
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            return false;
+
+        bytes += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+#endif //XORAI_PROTOCOL_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef XORAI_QUEUE_H
+#define XORAI_QUEUE_H
+
+#include <xorai/types.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+/* Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * The head and tail counters live on separate cache lines so the two sides never share one,
+ * and each side caches the other's counter to avoid touching it on every call. */
+template<typename _Tp>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(u64 capacity)
+        : slots(std::bit_ceil(std::max<u64>(capacity, 2))), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /* Moves `value` into the queue, or leaves it untouched and returns false when the queue is full. */
+    bool push(_Tp& value)
+    {
+        const u64 tail = this->tail.load(std::memory_order_relaxed);
+
+        if(tail - this->cached_head == this->slots.size())
+        {
+            this->cached_head = this->head.load(std::memory_order_acquire);
+
+            if(tail - this->cached_head == this->slots.size())
+                return false;
+        }
+
+        this->slots[tail & this->mask] = std::move(value);
+        this->tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /* Moves the oldest element into `value`, or returns false when the queue is empty. */
+    bool pop(_Tp& value)
+    {
+        const u64 head = this->head.load(std::memory_order_relaxed);
+
+        if(head == this->cached_tail)
+        {
+            this->cached_tail = this->tail.load(std::memory_order_acquire);
+
+            if(head == this->cached_tail)
+                return false;
+        }
+
+        value = std::move(this->slots[head & this->mask]);
+        this->head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+    cvector<_Tp> slots;
+    const u64 mask;
+
+    alignas(64) std::atomic<u64> head {0};     // Written by the consumer.
+    u64 cached_tail {0};
+
+    alignas(64) std::atomic<u64> tail {0};     // Written by the producer.
+    u64 cached_head {0};
+};
+
+#endif //XORAI_QUEUE_H
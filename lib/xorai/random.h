@@ -0,0 +1,70 @@
+#pragma once
+#ifndef XORAI_RANDOM_H
+#define XORAI_RANDOM_H
+
+#include <xorai/types.h>
+#include <random>
+#include <array>
+
+/* Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+ * Every output is a pure function of (seed, stream, counter), so any element
+ * can be generated independently and fills are identical for every thread count. */
+class Philox
+{
+public:
+    explicit Philox(u64 seed, u64 stream = 0)
+        : key({static_cast<u32>(seed), static_cast<u32>(seed >> 32)}), stream(stream) {}
+
+    std::array<u32, 4>
+    operator()(u64 counter) const
+    {
+        std::array<u32, 4> block = {
+            static_cast<u32>(counter), static_cast<u32>(counter >> 32),
+            static_cast<u32>(this->stream), static_cast<u32>(this->stream >> 32)
+        };
+        std::array<u32, 2> round_key = this->key;
+
+        for(u8 round = 0; round < 10; round++)
+        {
+            const u64 product0 = static_cast<u64>(0xD2511F53) * block[0];
+            const u64 product1 = static_cast<u64>(0xCD9E8D57) * block[2];
+
+            block = {
+                static_cast<u32>(product1 >> 32) ^ block[1] ^ round_key[0], static_cast<u32>(product1),
+                static_cast<u32>(product0 >> 32) ^ block[3] ^ round_key[1], static_cast<u32>(product0)
+            };
+
+            round_key[0] += 0x9E3779B9;
+            round_key[1] += 0xBB67AE85;
+        }
+
+        return block;
+    }
+
+    /* Uniform number in [0, 1) with 53 random bits for element `index`.
+     * Each 128-bit block provides two consecutive elements. */
+    f64
+    uniform(u64 index) const
+    {
+        const std::array<u32, 4> block = this->operator()(index >> 1);
+        const u64 bits = (index & 1)
+                ? (static_cast<u64>(block[2]) << 32) | block[3]
+                : (static_cast<u64>(block[0]) << 32) | block[1];
+
+        return static_cast<f64>(bits >> 11) * 0x1.0p-53;
+    }
+
+    /* A non-deterministic seed for when the caller does not provide one. */
+    static u64
+    entropy()
+    {
+        std::random_device rd;
+        return (static_cast<u64>(rd()) << 32) | rd();
+    }
+
+private:
+    std::array<u32, 2> key;
+    u64 stream;
+};
+
+#endif //XORAI_RANDOM_H
\ No newline at end of file
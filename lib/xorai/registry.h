@@ -0,0 +1,36 @@
+#pragma once
+#ifndef XORAI_REGISTRY_H
+#define XORAI_REGISTRY_H
+
+#include <xorai/network.h>
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+/* A process-wide cache of loaded model files, keyed by path and modification time.
+ * Every `open` of an unchanged file returns the same immutable network, so components that load
+ * the same model share one parsed copy of its weights. A file that changed on disk is loaded again,
+ * while handles to the old version stay valid. A model is only kept while some handle to it exists. */
+template<typename Float>
+class ModelRegistry
+{
+public:
+    using handle_t = std::shared_ptr<const Network<Float>>;
+
+    static handle_t open(const std::string&);
+    static Network<Float> fork(const std::string&);
+    static u64 size();
+
+private:
+    struct Entry
+    {
+        std::filesystem::file_time_type modified;
+        std::weak_ptr<const Network<Float>> network;
+    };
+
+    static std::mutex lock;
+    static std::unordered_map<std::string, Entry> entries;
+};
+
+#endif //XORAI_REGISTRY_H
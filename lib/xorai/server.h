@@ -0,0 +1,81 @@
+#pragma once
+#ifndef XORAI_SERVER_H
+#define XORAI_SERVER_H
+
+#include <xorai/network.h>
+#include <xorai/protocol.h>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+/* Serves a loaded network over a Unix-domain socket.
+ * Concurrent requests that arrive within `window` microseconds of each other
+ * (up to `max_batch` of them) are coalesced into one batched forward pass. */
+template<typename Float>
+class Server
+{
+private:
+    using matrix_t = Matrix<Float>;
+    using clock = std::chrono::steady_clock;
+
+    struct Connection
+    {
+        explicit Connection(i32 fd) : fd(fd) {}
+        ~Connection() { ::close(this->fd); }
+
+        const i32 fd;
+        std::mutex write_lock;
+    };
+
+    struct Request
+    {
+        std::shared_ptr<Connection> connection;
+        u32 id;
+        cvector<Float> inputs;
+        clock::time_point arrival;
+    };
+
+public:
+    Server(const Network<Float>&, std::string, u64 = 64, u64 = 200);
+    ~Server();
+
+    void run();
+    void stop();
+    ServerStats stats();
+
+    const std::string path;
+    const u64 max_batch;
+    const u64 window;
+
+private:
+    void serve_connection(std::shared_ptr<Connection>);
+    void batch_loop();
+    void respond(Connection&, u32, const f64*, u32);
+    void record(const cvector<Request>&);
+
+    const Network<Float>& network;
+    i32 listener;
+    std::atomic<bool> running;
+    clock::time_point started;
+
+    std::mutex queue_lock;
+    std::condition_variable queue_ready;
+    std::deque<Request> queue;
+
+    std::mutex connections_lock;
+    std::condition_variable connections_closed;
+    cvector<std::weak_ptr<Connection>> connections;
+    u64 active_connections;
+
+    std::mutex stats_lock;
+    cvector<f64> latencies;
+    u64 latency_cursor;
+    u64 requests;
+    u64 batches;
+};
+
+#endif //XORAI_SERVER_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XORAI_SPARSE_H
+#define XORAI_SPARSE_H
+
+#include <xorai/matrix.h>
+
+/* A weight matrix in compressed sparse row (CSR) form.
+ * `offsets[i]..offsets[i + 1]` index the `values` and column `indices` of row `i`. */
+template<typename Float>
+class SparseMatrix
+{
+private:
+    typedef Matrix<Float> matrix_t;
+    typedef SparseMatrix<Float> sparse_t;
+
+public:
+    SparseMatrix();
+    SparseMatrix(u64, u64, const cvector<u64>&, const cvector<u32>&, const cvector<Float>&);
+
+    matrix_t dot(MatrixView<const Float>) const;
+    matrix_t dense() const;
+    void mask(matrix_t&);
+
+    static sparse_t from(const matrix_t&);
+
+    u64 nonzeros() const;
+    f64 density() const;
+    bool empty() const;
+
+    u64 rows;
+    u64 cols;
+    cvector<u64> offsets;
+    cvector<u32> indices;
+    cvector<Float> values;
+};
+
+
+template<typename Float>
+using SparseArray = cvector<SparseMatrix<Float>>;
+
+#endif //XORAI_SPARSE_H
\ No newline at end of file
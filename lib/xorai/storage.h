@@ -0,0 +1,258 @@
+#pragma once
+#ifndef XORAI_STORAGE_H
+#define XORAI_STORAGE_H
+
+#include <xorai/types.h>
+#include <initializer_list>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <memory>
+#include <new>
+
+/* Both the inline buffer and heap buffers start on a cache line, and heap buffers are rounded up to
+ * whole cache lines, so vector loads are aligned and the padding past the last element is owned. */
+#define STORAGE_ALIGNMENT 64
+
+/* Contiguous, cache-line aligned element storage with an inline buffer for small sizes.
+ * Tiny matrices (such as the layers of a {2, 3, 1} network) never touch the heap.
+ *
+ * After `share()`, a heap buffer is copied by reference, and writers call `detach()` first to get
+ * their own copy if anyone else still holds it (copy-on-write). The element accessors do not check,
+ * so every write to a buffer that may be shared must be preceded by `detach()`. */
+template<typename _Tp, u64 _InlineCapacity = 8>
+class SmallBuffer
+{
+private:
+    typedef SmallBuffer<_Tp, _InlineCapacity> _SelfType;
+
+public:
+    SmallBuffer() = default;
+
+    explicit SmallBuffer(u64 size, _Tp value = _Tp())
+    {
+        resize(size, value);
+    }
+
+    SmallBuffer(std::initializer_list<_Tp> values)
+    {
+        assign(values.begin(), values.end());
+    }
+
+    template<typename _InputIterator>
+    SmallBuffer(_InputIterator first, _InputIterator last)
+    {
+        assign(first, last);
+    }
+
+    SmallBuffer(const _SelfType& other)
+    {
+        if(other.block)
+            borrow(other);
+        else
+            assign(other.begin(), other.end());
+    }
+
+    SmallBuffer(_SelfType&& other) noexcept
+    {
+        steal(other);
+    }
+
+    ~SmallBuffer()
+    {
+        release();
+    }
+
+    _SelfType&
+    operator=(const _SelfType& other)
+    {
+        if(this != &other && other.block)
+        {
+            release();
+            borrow(other);
+        }
+        else if(this != &other)
+            assign(other.begin(), other.end());
+
+        return *this;
+    }
+
+    _SelfType&
+    operator=(_SelfType&& other) noexcept
+    {
+        if(this != &other)
+        {
+            release();
+            steal(other);
+        }
+
+        return *this;
+    }
+
+    template<typename _InputIterator>
+    void
+    assign(_InputIterator first, _InputIterator last)
+    {
+        u64 size = std::distance(first, last);
+
+        detach(false);
+        reserve_exact(size);
+        std::copy(first, last, this->pointer);
+        this->count = size;
+    }
+
+    void
+    resize(u64 size, _Tp value = _Tp())
+    {
+        detach();
+        reserve_exact(size);
+
+        if(size > this->count)
+            std::fill(this->pointer + this->count, this->pointer + size, value);
+
+        this->count = size;
+    }
+
+    void
+    clear()
+    {
+        this->count = 0;
+    }
+
+    _Tp& operator[](u64 i) { return this->pointer[i]; }
+    const _Tp& operator[](u64 i) const { return this->pointer[i]; }
+
+    _Tp* data() { return this->pointer; }
+    const _Tp* data() const { return this->pointer; }
+
+    _Tp* begin() { return this->pointer; }
+    _Tp* end() { return this->pointer + this->count; }
+    const _Tp* begin() const { return this->pointer; }
+    const _Tp* end() const { return this->pointer + this->count; }
+
+    u64 size() const { return this->count; }
+    u64 padded_size() const { return this->capacity; }
+    bool empty() const { return this->count == 0; }
+    bool is_inline() const { return this->pointer == this->local; }
+    bool is_shared() const { return this->block && this->block.use_count() > 1; }
+
+    /* Lets copies of this buffer reference its heap memory instead of copying it.
+     * Inline buffers are cheap to copy and stay private. */
+    void
+    share()
+    {
+        if(is_inline() || this->block)
+            return;
+
+        const u64 capacity = this->capacity;
+
+        this->block = std::shared_ptr<_Tp>(this->pointer, [capacity](_Tp* pointer)
+        {
+            std::destroy_n(pointer, capacity);
+            ::operator delete(pointer, std::align_val_t(STORAGE_ALIGNMENT));
+        });
+    }
+
+    /* Gives this buffer its own memory if another buffer still references it, copying the elements
+     * unless `keep` is false (when they are about to be overwritten). */
+    void
+    detach(bool keep = true)
+    {
+        if(!is_shared())
+            return;
+
+        _Tp* buffer = allocate(this->capacity);
+
+        if(keep)
+            std::copy(this->pointer, this->pointer + this->count, buffer);
+
+        this->block.reset();
+        this->pointer = buffer;
+    }
+
+private:
+    /* Grows to `size` elements, rounded up to whole cache lines, while keeping the current contents. */
+    void
+    reserve_exact(u64 size)
+    {
+        if(size <= this->capacity)
+            return;
+
+        const u64 line = std::max<u64>(STORAGE_ALIGNMENT / sizeof(_Tp), 1);
+        size = (size + line - 1) / line * line;
+
+        _Tp* buffer = allocate(size);
+        std::copy(this->pointer, this->pointer + this->count, buffer);
+
+        release();
+
+        this->pointer = buffer;
+        this->capacity = size;
+    }
+
+    static _Tp*
+    allocate(u64 size)
+    {
+        _Tp* buffer = static_cast<_Tp*>(::operator new(size * sizeof(_Tp), std::align_val_t(STORAGE_ALIGNMENT)));
+        std::uninitialized_value_construct_n(buffer, size);
+
+        return buffer;
+    }
+
+    void
+    release()
+    {
+        if(this->block)
+            this->block.reset();
+        else if(!is_inline())
+        {
+            std::destroy_n(this->pointer, this->capacity);
+            ::operator delete(this->pointer, std::align_val_t(STORAGE_ALIGNMENT));
+        }
+
+        this->pointer = this->local;
+        this->capacity = _InlineCapacity;
+    }
+
+    /* Takes over `other`'s heap buffer, or copies its inline elements. */
+    void
+    steal(_SelfType& other)
+    {
+        if(other.is_inline())
+        {
+            std::copy(other.begin(), other.end(), this->local);
+            this->pointer = this->local;
+            this->capacity = _InlineCapacity;
+        }
+        else
+        {
+            this->pointer = other.pointer;
+            this->capacity = other.capacity;
+            this->block = std::move(other.block);
+        }
+
+        this->count = other.count;
+
+        other.pointer = other.local;
+        other.capacity = _InlineCapacity;
+        other.count = 0;
+    }
+
+    /* References the heap buffer of `other`, which has been shared. */
+    void
+    borrow(const _SelfType& other)
+    {
+        this->pointer = other.pointer;
+        this->capacity = other.capacity;
+        this->count = other.count;
+        this->block = other.block;
+    }
+
+    alignas(STORAGE_ALIGNMENT) _Tp local[_InlineCapacity];
+    _Tp* pointer = local;
+    u64 capacity = _InlineCapacity;
+    u64 count = 0;
+    std::shared_ptr<_Tp> block;
+};
+
+#endif //XORAI_STORAGE_H
\ No newline at end of file
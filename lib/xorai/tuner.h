@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XORAI_TUNER_H
+#define XORAI_TUNER_H
+
+#include <jsoncpp/json/value.h>
+#include <xorai/kernels.h>
+#include <mutex>
+
+/* Picks the fastest `GemmConfig` for each matrix product shape by timing candidates on this machine.
+ * Results are kept in a JSON cache file under the CPU model, so runs on the same machine reuse them
+ * without tuning again, and one file can be shared between machines:
+ *
+ *   {"<cpu model> (<threads> threads)": {"f64 1024x512x64 naive": {"strategy": "blocked", ...}}} */
+class KernelTuner
+{
+public:
+    explicit KernelTuner(std::string = default_path());
+
+    template<typename Float>
+    GemmConfig tune(u64, u64, u64, Accumulation = Accumulation::Naive);
+
+    static std::string default_path();
+    static std::string cpu_model();
+
+    const std::string path;
+    const std::string machine;
+    u64 benchmarked;        // Shapes timed by this tuner instead of found in the cache.
+
+private:
+    template<typename Float>
+    GemmConfig benchmark(u64, u64, u64, Accumulation, f64&) const;
+
+    void load();
+    Json::Value read() const;
+    void save();
+
+    std::mutex lock;
+    Json::Value root;
+};
+
+#endif //XORAI_TUNER_H
@@ -2,16 +2,17 @@
 #ifndef XORAI_TYPES_H
 #define XORAI_TYPES_H
 
+#include <xorai/double_double.h>
 #include <xorai/config.h>
 #include <vector>
 
 #define BASIC_UNARY(arg, code) (const auto& arg) { return code; }
-#define BASIC_UNARY_DELETE [](auto* a) { delete(a); }
 
 #define INSTANTIATE_CLASS_FLOATS(c) \
     template class c<f32>;          \
     template class c<f64>;          \
-    template class c<f128>;
+    template class c<f128>;         \
+    template class c<fdd>;
 
 #define S signed
 #define U unsigned
@@ -46,6 +47,12 @@ T(long double, f128);
 #define MAX_F128_PRECISION MAX_F64_PRECISION
 #endif
 
+/* Double-double: two f64s giving ~106 bits (about 32 decimal digits) of mantissa. */
+T(DoubleDouble, fdd);
+
+#define MIN_FDD_PRECISION 30
+#define MAX_FDD_PRECISION 32
+
 #define UseMinPrecision(bitsize) MIN_F ## bitsize ## _PRECISION
 #define UseMaxPrecision(bitsize) MAX_F ## bitsize ## _PRECISION
 #define UsePrecision(bitsize) UseMinPrecision(bitsize)
@@ -71,7 +78,7 @@ template<typename _Tp, typename... _Types>
 constexpr bool is_type_of = (std::is_same_v<_Tp, _Types> || ...);
 
 template<typename _Tp>
-constexpr bool is_float_type = is_type_of<_Tp, f32, f64, f128>;
+constexpr bool is_float_type = is_type_of<_Tp, f32, f64, f128, fdd>;
 
 template<typename _Tp, typename _Alloc = std::allocator<_Tp>>
 class cvector : public std::vector<_Tp, _Alloc>
@@ -180,6 +187,7 @@ T(cvector<u64>,  U64Array);
 T(cvector<f32>,  F32Array);
 T(cvector<f64>,  F64Array);
 T(cvector<f128>, F128Array);
+T(cvector<fdd>,  FDDArray);
 
 template<typename Float = f32>
 using Dataset = cvector<cvector<Float>>;
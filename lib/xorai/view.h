@@ -0,0 +1,64 @@
+#pragma once
+#ifndef XORAI_VIEW_H
+#define XORAI_VIEW_H
+
+#include <xorai/types.h>
+#include <type_traits>
+
+/* A non-owning window onto row-major storage: `rows` x `cols` elements whose rows start `stride`
+ * elements apart. Slicing only moves the pointer and changes the shape, so a range of samples
+ * (columns) of a batch or a block of a weight matrix is used in place instead of being copied.
+ * `MatrixView<const Float>` is the read-only form; every view converts to it. */
+template<typename Float>
+struct MatrixView
+{
+    MatrixView() = default;
+
+    MatrixView(Float* data, u64 rows, u64 cols, u64 stride)
+        : data(data), rows(rows), cols(cols), stride(stride) {}
+
+    MatrixView(Float* data, u64 rows, u64 cols)
+        : MatrixView(data, rows, cols, cols) {}
+
+    template<typename Other> requires std::is_same_v<Float, const Other>
+    MatrixView(const MatrixView<Other>& other)
+        : MatrixView(other.data, other.rows, other.cols, other.stride) {}
+
+    Float& operator()(u64 row, u64 col) const
+    {
+        return this->data[row * this->stride + col];
+    }
+
+    Float* row(u64 index) const
+    {
+        return this->data + index * this->stride;
+    }
+
+    MatrixView block(u64 row, u64 col, u64 rows, u64 cols) const
+    {
+        return MatrixView(this->data + row * this->stride + col, rows, cols, this->stride);
+    }
+
+    MatrixView row_range(u64 first, u64 count) const
+    {
+        return block(first, 0, count, this->cols);
+    }
+
+    MatrixView col_range(u64 first, u64 count) const
+    {
+        return block(0, first, this->rows, count);
+    }
+
+    /* True when the elements have no gaps between rows, i.e. the view is one flat array. */
+    bool contiguous() const
+    {
+        return this->stride == this->cols || this->rows <= 1;
+    }
+
+    Float* data = nullptr;
+    u64 rows = 0;
+    u64 cols = 0;
+    u64 stride = 0;
+};
+
+#endif //XORAI_VIEW_H
@@ -31,13 +31,10 @@ void use_model()
     Network<f64> network("model.xorai");
 
     /* Test the model with the given inputs. */
-    Matrix<f64>* result = network.test(1.0, 1.0);
+    Matrix<f64> result = network.test(1.0, 1.0);
 
     /* Display the result. */
     Matrix<f64>::display(result);
-
-    /* Free the memory allocated for the result. */
-    delete(result);
 }
 
 int main()
@@ -5,7 +5,13 @@
 #define INSTANTIATE_FUNCTION_FLOATS(f) \
     template f32 f<f32>(f32 x);        \
     template f64 f<f64>(f64 x);        \
-    template f128 f<f128>(f128 x);
+    template f128 f<f128>(f128 x);     \
+    template fdd f<fdd>(fdd x);
+
+#define INSTANTIATE_ACTIVATION_KERNELS(Float)                                      \
+    template void activate<Float>(Activation, Float*, u64);                        \
+    template void activate<Float>(Activation, Float*, const Float*, u64, u64);     \
+    template void apply_derivative<Float>(Activation, const Float*, Float*, u64);
 
 template<typename Float>
 Float Exp(Float x)
@@ -20,6 +26,8 @@ Float Exp(Float x)
 #else
         return expl(x);
 #endif
+    else if constexpr (std::is_same_v<Float, fdd>)
+        return fdd::exp(x);
 
     std::cout << "[C++ Activation]: Unsupported float type " << typeid(Float).name() << std::endl;
     exit(EXIT_FAILURE);
@@ -37,6 +45,132 @@ Float derivative(Float x)
     return x * (1.0 - x);
 }
 
+template<typename Float>
+static Float hyperbolic_tangent(Float x)
+{
+    if constexpr (std::is_same_v<Float, f32> || std::is_same_v<Float, f64> || std::is_same_v<Float, long double>)
+        return std::tanh(x);
+    else
+    {
+        /* tanh(|x|) = (1 - e^-2|x|) / (1 + e^-2|x|), which cannot overflow. */
+        Float t = Exp<Float>((x < 0 ? x : -x) * 2.0);
+        Float y = (1.0 - t) / (1.0 + t);
+
+        return x < 0 ? -y : y;
+    }
+}
+
+/* Applies `func` to every element of a row-major matrix after adding its row's bias.
+ * Each activation gets its own instantiation, so the inner loop has no branch on the kind. */
+template<typename Float, typename Function>
+static void transform(Float* values, const Float* biases, u64 rows, u64 cols, Function func)
+{
+    for(u64 r = 0; r < rows; r++)
+    {
+        Float* row = values + r * cols;
+
+        if(biases == nullptr)
+            for(u64 c = 0; c < cols; c++)
+                row[c] = func(row[c]);
+        else
+        {
+            const Float bias = biases[r];
+
+            for(u64 c = 0; c < cols; c++)
+                row[c] = func(row[c] + bias);
+        }
+    }
+}
+
+template<typename Float>
+void activate(Activation activation, Float* values, const Float* biases, u64 rows, u64 cols)
+{
+    const Float slope = LEAKY_RELU_SLOPE;
+
+    switch(activation)
+    {
+        case Activation::Sigmoid:
+            transform(values, biases, rows, cols, [](Float x) { return sigmoid<Float>(x); });
+            break;
+        case Activation::ReLU:
+            transform(values, biases, rows, cols, [](Float x) { return x > 0 ? x : Float(0.0); });
+            break;
+        case Activation::LeakyReLU:
+            transform(values, biases, rows, cols, [slope](Float x) { return x > 0 ? x : x * slope; });
+            break;
+        case Activation::Tanh:
+            transform(values, biases, rows, cols, [](Float x) { return hyperbolic_tangent<Float>(x); });
+            break;
+        case Activation::Identity:
+            transform(values, biases, rows, cols, [](Float x) { return x; });
+            break;
+    }
+}
+
+template<typename Float>
+void activate(Activation activation, Float* values, u64 count)
+{
+    activate<Float>(activation, values, nullptr, 1, count);
+}
+
+template<typename Float>
+void apply_derivative(Activation activation, const Float* outputs, Float* errors, u64 count)
+{
+    const Float slope = LEAKY_RELU_SLOPE;
+
+    switch(activation)
+    {
+        case Activation::Sigmoid:
+            for(u64 k = 0; k < count; k++)
+                errors[k] = derivative<Float>(outputs[k]) * errors[k];
+            break;
+        case Activation::ReLU:
+            for(u64 k = 0; k < count; k++)
+                errors[k] = outputs[k] > 0 ? errors[k] : Float(0.0);
+            break;
+        case Activation::LeakyReLU:
+            for(u64 k = 0; k < count; k++)
+                errors[k] = outputs[k] > 0 ? errors[k] : errors[k] * slope;
+            break;
+        case Activation::Tanh:
+            for(u64 k = 0; k < count; k++)
+                errors[k] = (1.0 - outputs[k] * outputs[k]) * errors[k];
+            break;
+        case Activation::Identity:
+            break;
+    }
+}
+
+const char* activation_name(Activation activation)
+{
+    switch(activation)
+    {
+        case Activation::Sigmoid: return "sigmoid";
+        case Activation::ReLU: return "relu";
+        case Activation::LeakyReLU: return "leaky_relu";
+        case Activation::Tanh: return "tanh";
+        case Activation::Identity: return "identity";
+    }
+
+    return "";
+}
+
+Activation parse_activation(const std::string& name)
+{
+    for(Activation activation : {Activation::Sigmoid, Activation::ReLU, Activation::LeakyReLU,
+                                 Activation::Tanh, Activation::Identity})
+        if(name == activation_name(activation))
+            return activation;
+
+    std::cout << "[C++ Activation]: Unknown activation function `" << name << "`\n";
+    std::cout << "\tSupported activations: [sigmoid, relu, leaky_relu, tanh, identity]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
 INSTANTIATE_FUNCTION_FLOATS(Exp)
 INSTANTIATE_FUNCTION_FLOATS(sigmoid)
-INSTANTIATE_FUNCTION_FLOATS(derivative)
\ No newline at end of file
+INSTANTIATE_FUNCTION_FLOATS(derivative)
+INSTANTIATE_ACTIVATION_KERNELS(f32)
+INSTANTIATE_ACTIVATION_KERNELS(f64)
+INSTANTIATE_ACTIVATION_KERNELS(f128)
+INSTANTIATE_ACTIVATION_KERNELS(fdd)
@@ -0,0 +1,269 @@
+#include <xorai/activation.h>
+#include <xorai/bank.h>
+#include <algorithm>
+#include <cassert>
+
+#define matrix_t Matrix<Float>
+
+/* Each model is initialized by the same code path as a standalone `Network`,
+ * so model `m` starts from exactly the weights `Network(layers, learning_rates[m], initializer, seeds[m])` would. */
+template<typename Float>
+ModelBank<Float>::ModelBank(const U64Array& layers, const cvector<Float>& learning_rates, const U64Array& seeds,
+                            Initializer initializer)
+    : layers(layers), learning_rates(learning_rates.clone()), seeds(seeds.clone()),
+      activations(layers.size() - 1, Activation::Sigmoid)
+{
+    assert(layers.size() > 1 && !learning_rates.empty() && learning_rates.size() == seeds.size());
+
+    const u64 n = size();
+
+    for(u64 i = 0; i < layers.size() - 1; i++)
+    {
+        this->weights.push_back(cvector<Float>(layers[i + 1] * layers[i] * n));
+        this->biases.push_back(cvector<Float>(layers[i + 1] * n));
+    }
+
+    for(u64 m = 0; m < n; m++)
+    {
+        Network<Float> network(layers, learning_rates[m], initializer, seeds[m]);
+
+        for(u64 i = 0; i < layers.size() - 1; i++)
+        {
+            for(u64 k = 0; k < network.weights[i].data.size(); k++)
+                this->weights[i][k * n + m] = network.weights[i].data[k];
+
+            for(u64 k = 0; k < network.biases[i].data.size(); k++)
+                this->biases[i][k * n + m] = network.biases[i].data[k];
+        }
+    }
+}
+
+/* Trains every model on the same samples, one sample at a time like `Network::train`. */
+template<typename Float>
+void ModelBank<Float>::train(Dataset<Float>& inputs, Dataset<Float>& targets, u64 epochs)
+{
+    assert(inputs.size() == targets.size());
+
+    const u64 n = size();
+
+    this->neurons.resize(this->layers.size());
+    this->errors.resize(this->layers.size());
+
+    for(u64 i = 0; i < this->layers.size(); i++)
+    {
+        this->neurons[i].resize(this->layers[i] * n);
+        this->errors[i].resize(this->layers[i] * n);
+    }
+
+    this->gradients.resize(*std::max_element(this->layers.begin(), this->layers.end()) * n);
+
+    for(u64 i = 1; i < epochs + 1; i++)
+    {
+#if defined(DEBUG) && !defined(NO_DEBUG)
+        if((epochs < 100) || (i % (epochs / 100) == 0))
+            std::cout << "Epoch " << i << " of " << epochs << "\n";
+#endif
+        for(u64 j = 0; j < inputs.size(); j++)
+        {
+            feed_forward(inputs[j]);
+            back_propagate(targets[j]);
+        }
+    }
+}
+
+/* Runs one sample through every model; column `m` of the result holds the outputs of model `m`. */
+template<typename Float>
+matrix_t ModelBank<Float>::predict(const cvector<Float>& inputs) const
+{
+    assert(inputs.size() == this->layers[0]);
+
+    const u64 n = size();
+    cvector<Float> current(inputs.size() * n), next;
+
+    for(u64 c = 0; c < inputs.size(); c++)
+        std::fill_n(current.begin() + c * n, n, inputs[c]);
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+        next.assign(rows * n, 0.0);
+
+        for(u64 r = 0; r < rows; r++)
+        {
+            Float* out = next.data() + r * n;
+
+            for(u64 c = 0; c < cols; c++)
+            {
+                const Float* w = this->weights[i].data() + (r * cols + c) * n;
+                const Float* a = current.data() + c * n;
+
+                for(u64 m = 0; m < n; m++)
+                    out[m] += w[m] * a[m];
+            }
+
+            for(u64 m = 0; m < n; m++)
+                out[m] += this->biases[i][r * n + m];
+
+            activate(this->activations[i], out, n);
+        }
+
+        std::swap(current, next);
+    }
+
+    return matrix_t(this->layers.back(), n, current);
+}
+
+/* Extracts model `m` as a standalone network, including its activations of the last training sample. */
+template<typename Float>
+Network<Float> ModelBank<Float>::network(u64 model) const
+{
+    assert(model < size());
+
+    const u64 n = size();
+    Model<Float> parameters;
+
+    parameters.layers = this->layers;
+    parameters.activations = this->activations;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        parameters.weights.push_back(matrix_t(this->layers[i + 1], this->layers[i]));
+        parameters.biases.push_back(matrix_t(this->layers[i + 1], 1));
+
+        for(u64 k = 0; k < parameters.weights[i].data.size(); k++)
+            parameters.weights[i].data[k] = this->weights[i][k * n + model];
+
+        for(u64 k = 0; k < parameters.biases[i].data.size(); k++)
+            parameters.biases[i].data[k] = this->biases[i][k * n + model];
+    }
+
+    for(const cvector<Float>& layer : this->neurons)
+    {
+        parameters.data.push_back(matrix_t(layer.size() / n, 1));
+
+        for(u64 k = 0; k < parameters.data.back().data.size(); k++)
+            parameters.data.back().data[k] = layer[k * n + model];
+    }
+
+    Network<Float> network(std::move(parameters), this->learning_rates[model]);
+    network.seed = this->seeds[model];
+
+    return network;
+}
+
+template<typename Float>
+void ModelBank<Float>::save(u64 model, std::string filename, i8 float_precision) const
+{
+    network(model).save(std::move(filename), float_precision);
+}
+
+template<typename Float>
+u64 ModelBank<Float>::size() const
+{
+    return this->learning_rates.size();
+}
+
+template<typename Float>
+void ModelBank<Float>::feed_forward(const cvector<Float>& inputs)
+{
+    assert(inputs.size() == this->layers[0]);
+
+    const u64 n = size();
+
+    for(u64 c = 0; c < inputs.size(); c++)
+        std::fill_n(this->neurons[0].begin() + c * n, n, inputs[c]);
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+
+        for(u64 r = 0; r < rows; r++)
+        {
+            Float* out = this->neurons[i + 1].data() + r * n;
+            std::fill_n(out, n, 0.0);
+
+            for(u64 c = 0; c < cols; c++)
+            {
+                const Float* w = this->weights[i].data() + (r * cols + c) * n;
+                const Float* a = this->neurons[i].data() + c * n;
+
+                for(u64 m = 0; m < n; m++)
+                    out[m] += w[m] * a[m];
+            }
+
+            for(u64 m = 0; m < n; m++)
+                out[m] += this->biases[i][r * n + m];
+
+            activate(this->activations[i], out, n);
+        }
+    }
+}
+
+/* Mirrors `Network::back_propagate` lane by lane: the errors are pushed back through
+ * the already updated weights, and every model scales its step by its own learning rate. */
+template<typename Float>
+void ModelBank<Float>::back_propagate(const cvector<Float>& targets)
+{
+    const u64 n = size();
+    const u64 last = this->layers.size() - 1;
+    const Float* rates = this->learning_rates.data();
+
+    for(u64 r = 0; r < this->layers[last]; r++)
+        for(u64 m = 0; m < n; m++)
+            this->errors[last][r * n + m] = targets[r] - this->neurons[last][r * n + m];
+
+    for(u64 i = last; i--;)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+
+        const Float* outputs = this->neurons[i + 1].data();
+        const Float* inputs = this->neurons[i].data();
+        const Float* errors = this->errors[i + 1].data();
+        Float* steps = this->gradients.data();
+
+        std::copy_n(errors, rows * n, steps);
+        apply_derivative(this->activations[i], outputs, steps, rows * n);
+
+        for(u64 k = 0; k < rows * n; k += n)
+            for(u64 m = 0; m < n; m++)
+                steps[k + m] *= rates[m];
+
+        for(u64 r = 0; r < rows; r++)
+        {
+            const Float* step = steps + r * n;
+
+            for(u64 c = 0; c < cols; c++)
+            {
+                Float* w = this->weights[i].data() + (r * cols + c) * n;
+                const Float* a = inputs + c * n;
+
+                for(u64 m = 0; m < n; m++)
+                    w[m] += step[m] * a[m];
+            }
+
+            Float* b = this->biases[i].data() + r * n;
+
+            for(u64 m = 0; m < n; m++)
+                b[m] += step[m];
+        }
+
+        if(i == 0)
+            break;
+
+        Float* propagated = this->errors[i].data();
+        std::fill_n(propagated, cols * n, 0.0);
+
+        for(u64 r = 0; r < rows; r++)
+            for(u64 c = 0; c < cols; c++)
+            {
+                const Float* w = this->weights[i].data() + (r * cols + c) * n;
+                const Float* e = errors + r * n;
+                Float* p = propagated + c * n;
+
+                for(u64 m = 0; m < n; m++)
+                    p[m] += w[m] * e[m];
+            }
+    }
+}
+
+INSTANTIATE_CLASS_FLOATS(ModelBank)
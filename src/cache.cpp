@@ -0,0 +1,144 @@
+#include <xorai/cache.h>
+#include <cstring>
+#include <limits>
+
+/* The bytes that hold a value: an x87 `long double` uses 10 of its 16, the rest is padding with undefined contents. */
+template<typename Float>
+constexpr u64 value_bytes()
+{
+    if constexpr(std::is_same_v<Float, long double>)
+        return std::numeric_limits<long double>::digits == 64 ? 10 : sizeof(Float);
+    else
+        return sizeof(Float);
+}
+
+/* The key of `count` inputs, their value bytes. Inputs without padding are used in place, others are packed. */
+template<typename Float>
+static std::string_view key_of(const Float* inputs, u64 count, std::string& packed)
+{
+    constexpr u64 width = value_bytes<Float>();
+
+    if constexpr(width == sizeof(Float))
+        return {reinterpret_cast<const char*>(inputs), count * sizeof(Float)};
+    else
+    {
+        packed.resize(count * width);
+
+        for(u64 i = 0; i < count; i++)
+            std::memcpy(packed.data() + i * width, inputs + i, width);
+
+        return packed;
+    }
+}
+
+template<typename Float>
+InferenceCache<Float>::InferenceCache(u64 capacity, u64 shards)
+    : capacity(std::max<u64>(capacity, 1)), shards(std::clamp<u64>(shards, 1, std::max<u64>(capacity, 1)))
+{
+    this->shard_capacity = (this->capacity + this->shards.size() - 1) / this->shards.size();
+}
+
+/* Copies the result of `inputs` under weights `version` into `result` and returns true if it is cached. */
+template<typename Float>
+bool InferenceCache<Float>::find(u64 version, const Float* inputs, u64 count, matrix_t& result)
+{
+    std::string packed;
+    const std::string_view key = key_of(inputs, count, packed);
+    Shard& shard = this->shard(key);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(key);
+
+    if(found == shard.index.end())
+    {
+        shard.misses++;
+        return false;
+    }
+
+    if(found->second->version != version)
+    {
+        shard.order.erase(found->second);
+        shard.index.erase(found);
+        shard.stale++;
+        shard.misses++;
+        return false;
+    }
+
+    shard.order.splice(shard.order.begin(), shard.order, found->second);
+    result = found->second->result;
+    shard.hits++;
+    return true;
+}
+
+/* Stores the result of `inputs` under weights `version`, replacing any older one. */
+template<typename Float>
+void InferenceCache<Float>::insert(u64 version, const Float* inputs, u64 count, const matrix_t& result)
+{
+    std::string packed;
+    const std::string_view key = key_of(inputs, count, packed);
+    Shard& shard = this->shard(key);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(key);
+
+    if(found != shard.index.end())
+    {
+        found->second->version = version;
+        found->second->result = result;
+        shard.order.splice(shard.order.begin(), shard.order, found->second);
+        return;
+    }
+
+    if(shard.order.size() >= this->shard_capacity)
+    {
+        shard.index.erase(shard.order.back().key);
+        shard.order.pop_back();
+        shard.evictions++;
+    }
+
+    /* The index refers to the key inside the list node, which never moves. */
+    shard.order.push_front({std::string(key), version, result});
+    shard.index.emplace(shard.order.front().key, shard.order.begin());
+}
+
+template<typename Float>
+void InferenceCache<Float>::clear()
+{
+    for(Shard& shard : this->shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        shard.index.clear();
+        shard.order.clear();
+        shard.hits = shard.misses = shard.stale = shard.evictions = 0;
+    }
+}
+
+template<typename Float>
+CacheStats InferenceCache<Float>::stats() const
+{
+    CacheStats stats = {};
+
+    for(const Shard& shard : this->shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.stale += shard.stale;
+        stats.evictions += shard.evictions;
+        stats.entries += shard.order.size();
+    }
+
+    return stats;
+}
+
+/* Picks a shard from the upper bits of the key's hash, so that shards and buckets do not split keys alike. */
+template<typename Float>
+typename InferenceCache<Float>::Shard& InferenceCache<Float>::shard(std::string_view key)
+{
+    const u64 hash = std::hash<std::string_view>()(key);
+    return this->shards[(hash >> 32 ^ hash >> 48) % this->shards.size()];
+}
+
+INSTANTIATE_CLASS_FLOATS(InferenceCache)
@@ -0,0 +1,72 @@
+#include <xorai/client.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+Client::Client(const std::string& path)
+    : fd(-1), next_id(0)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if(path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "[C++ Client]: Socket path is too long: `" << path << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::strcpy(address.sun_path, path.c_str());
+    this->fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(this->fd < 0 || ::connect(this->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        std::cout << "[C++ Client]: Failed to connect to `" << path << "`\n";
+        std::cout << "[!] " << std::strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+Client::~Client()
+{
+    ::close(this->fd);
+}
+
+/* Returns the network's outputs for one input sample, or an empty array if the server rejected it. */
+F64Array Client::infer(const F64Array& inputs)
+{
+    return request(Opcode::Infer, inputs);
+}
+
+ServerStats Client::stats()
+{
+    ServerStats stats {};
+    F64Array values = request(Opcode::Stats, {});
+
+    std::memcpy(&stats, values.data(), std::min(values.size() * sizeof(f64), sizeof(stats)));
+    return stats;
+}
+
+F64Array Client::request(Opcode opcode, const F64Array& values)
+{
+    RequestHeader header {opcode, this->next_id++, static_cast<u32>(values.size())};
+    ResponseHeader response {};
+
+    if(!write_exact(this->fd, &header, sizeof(header))
+        || !write_exact(this->fd, values.data(), values.size() * sizeof(f64))
+        || !read_exact(this->fd, &response, sizeof(response)))
+    {
+        std::cout << "[C++ Client]: Lost the connection to the server." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    F64Array output(response.count);
+
+    if(!read_exact(this->fd, output.data(), response.count * sizeof(f64)))
+    {
+        std::cout << "[C++ Client]: Lost the connection to the server." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,409 @@
+#include <xorai/compress.h>
+#include <xorai/parallel.h>
+#include <cstring>
+#include <atomic>
+
+/* Values per independently coded block. */
+#define COMPRESS_BLOCK_VALUES 65536
+
+/* rANS with byte-wise renormalization: frequencies scaled to sum to 2^RANS_PROB_BITS,
+ * and a 32-bit state kept in [RANS_LOW, RANS_LOW << 8). */
+#define RANS_PROB_BITS 12
+#define RANS_LOW (1u << 23)
+
+/* How a byte plane is stored. */
+enum class PlaneMode : u8
+{
+    Raw = 0,
+    Constant = 1,
+    Rans = 2
+};
+
+/* Scales the byte counts of `n` symbols to frequencies summing to 2^RANS_PROB_BITS, keeping every seen byte. */
+static void normalize(const u64* counts, u64 n, u32* freqs)
+{
+    const u32 total = 1u << RANS_PROB_BITS;
+    u32 sum = 0;
+
+    for(u64 s = 0; s < 256; s++)
+    {
+        freqs[s] = counts[s] ? std::max<u32>(1, static_cast<u32>(counts[s] * total / n)) : 0;
+        sum += freqs[s];
+    }
+
+    /* Rounding leaves the sum a little off; the most frequent bytes absorb the difference. */
+    while(sum != total)
+    {
+        u64 largest = 0;
+
+        for(u64 s = 1; s < 256; s++)
+            if(freqs[s] > freqs[largest])
+                largest = s;
+
+        if(sum < total)
+        {
+            freqs[largest] += total - sum;
+            sum = total;
+        }
+        else
+        {
+            const u32 cut = std::min(sum - total, freqs[largest] - 1);
+            freqs[largest] -= cut;
+            sum -= cut;
+        }
+    }
+}
+
+/* Appends one byte plane of `n` bytes to `out`: a mode byte and the plane in that mode. */
+static void encode_plane(const u8* plane, u64 n, std::string& out)
+{
+    u64 counts[256] = {};
+
+    for(u64 i = 0; i < n; i++)
+        counts[plane[i]]++;
+
+    if(counts[plane[0]] == n)
+    {
+        out.push_back(static_cast<char>(PlaneMode::Constant));
+        out.push_back(static_cast<char>(plane[0]));
+        return;
+    }
+
+    u32 freqs[256], starts[256];
+    normalize(counts, n, freqs);
+
+    for(u32 s = 0, start = 0; s < 256; start += freqs[s], s++)
+        starts[s] = start;
+
+    /* rANS encodes backwards, so the bytes are written from the end of a buffer that fits the worst case. */
+    std::string buffer(2 * n + 8, '\0');
+    u8* end = reinterpret_cast<u8*>(buffer.data()) + buffer.size();
+    u8* at = end;
+    u32 state = RANS_LOW;
+
+    for(u64 i = n; i-- > 0;)
+    {
+        const u32 freq = freqs[plane[i]];
+        const u32 limit = ((RANS_LOW >> RANS_PROB_BITS) << 8) * freq;
+
+        while(state >= limit)
+        {
+            *--at = static_cast<u8>(state);
+            state >>= 8;
+        }
+
+        state = ((state / freq) << RANS_PROB_BITS) + (state % freq) + starts[plane[i]];
+    }
+
+    at -= sizeof(state);
+    std::memcpy(at, &state, sizeof(state));
+
+    /* The table lists the frequencies of the bytes set in a 256-bit map. */
+    u8 present[32] = {};
+    u64 symbols = 0;
+
+    for(u64 s = 0; s < 256; s++)
+        if(freqs[s])
+        {
+            present[s / 8] |= static_cast<u8>(1u << (s % 8));
+            symbols++;
+        }
+
+    const u64 coded = sizeof(present) + symbols * sizeof(u16) + static_cast<u64>(end - at);
+
+    if(coded >= n)
+    {
+        out.push_back(static_cast<char>(PlaneMode::Raw));
+        out.append(reinterpret_cast<const char*>(plane), n);
+        return;
+    }
+
+    out.push_back(static_cast<char>(PlaneMode::Rans));
+    out.append(reinterpret_cast<const char*>(present), sizeof(present));
+
+    for(u64 s = 0; s < 256; s++)
+        if(freqs[s])
+        {
+            const u16 freq = static_cast<u16>(freqs[s]);
+            out.append(reinterpret_cast<const char*>(&freq), sizeof(freq));
+        }
+
+    out.append(reinterpret_cast<const char*>(at), static_cast<u64>(end - at));
+}
+
+/* Decodes the byte plane of `n` bytes in the `size` bytes at `source`. */
+static bool decode_plane(const u8* source, u64 size, u8* plane, u64 n)
+{
+    if(size < 1)
+        return false;
+
+    const auto mode = static_cast<PlaneMode>(source[0]);
+    const u8* end = source + size;
+    source++;
+
+    if(mode == PlaneMode::Raw)
+    {
+        if(static_cast<u64>(end - source) != n)
+            return false;
+
+        std::memcpy(plane, source, n);
+        return true;
+    }
+
+    if(mode == PlaneMode::Constant)
+    {
+        if(end - source != 1)
+            return false;
+
+        std::memset(plane, source[0], n);
+        return true;
+    }
+
+    if(mode != PlaneMode::Rans || end - source < 32)
+        return false;
+
+    const u8* present = source;
+    source += 32;
+
+    u32 freqs[256] = {}, starts[256] = {}, total = 0;
+    u8 symbols[1u << RANS_PROB_BITS];
+
+    for(u32 s = 0; s < 256; s++)
+    {
+        if(!(present[s / 8] >> (s % 8) & 1))
+            continue;
+
+        u16 freq;
+
+        if(end - source < static_cast<i64>(sizeof(freq)))
+            return false;
+
+        std::memcpy(&freq, source, sizeof(freq));
+        source += sizeof(freq);
+
+        if(freq == 0 || total + freq > (1u << RANS_PROB_BITS))
+            return false;
+
+        freqs[s] = freq;
+        starts[s] = total;
+        std::memset(symbols + total, static_cast<i32>(s), freq);
+        total += freq;
+    }
+
+    u32 state;
+
+    if(total != (1u << RANS_PROB_BITS) || end - source < static_cast<i64>(sizeof(state)))
+        return false;
+
+    std::memcpy(&state, source, sizeof(state));
+    source += sizeof(state);
+
+    for(u64 i = 0; i < n; i++)
+    {
+        const u32 slot = state & ((1u << RANS_PROB_BITS) - 1);
+        const u8 symbol = symbols[slot];
+
+        plane[i] = symbol;
+        state = freqs[symbol] * (state >> RANS_PROB_BITS) + slot - starts[symbol];
+
+        while(state < RANS_LOW)
+        {
+            if(source == end)
+                return false;
+
+            state = state << 8 | *source++;
+        }
+    }
+
+    return source == end;
+}
+
+/* What a block's values are XORed with before shuffling. */
+enum class Predictor : u8
+{
+    None = 0,
+    Previous = 1,
+    Base = 2
+};
+
+/* The prediction of byte `k` of value `i` of a block. */
+static inline u8 predict(Predictor predictor, const u8* values, const u8* base, u64 i, u64 k, u64 width)
+{
+    switch(predictor)
+    {
+        case Predictor::Previous: return i > 0 ? values[(i - 1) * width + k] : 0;
+        case Predictor::Base: return base[i * width + k];
+        default: return 0;
+    }
+}
+
+/* A compressed array is:
+ *
+ *   u64 size (of the rest) | u64 count | u64 width | u64 block values
+ *   | per block: u8 predictor, per byte plane: u32 size | the planes in the same order
+ *
+ * Each block is coded both with the prediction (the base, or else the value before) and without, and keeps the
+ * smaller: the values of unrelated weights rarely share more than their exponents, which shuffling alone exploits.
+ * The first value of a block predicts from zero, so that every block can be decoded on its own. */
+void compress_values(const char* values, const char* base, u64 count, u64 width, std::string& out)
+{
+    const u64 blocks = (count + COMPRESS_BLOCK_VALUES - 1) / COMPRESS_BLOCK_VALUES;
+    cvector<Predictor> predictors(blocks);
+    cvector<std::string> coded(blocks * width);
+
+    parallel_for(blocks, 1, [&](u64 begin, u64 end)
+    {
+        std::string planes;
+        cvector<std::string> trial(width);
+
+        for(u64 b = begin; b < end; b++)
+        {
+            const u64 first = b * COMPRESS_BLOCK_VALUES;
+            const u64 n = std::min<u64>(COMPRESS_BLOCK_VALUES, count - first);
+            const u8* in = reinterpret_cast<const u8*>(values) + first * width;
+            const u8* reference = base ? reinterpret_cast<const u8*>(base) + first * width : nullptr;
+
+            planes.resize(n * width);
+            u8* shuffled = reinterpret_cast<u8*>(planes.data());
+            u64 best = ~u64(0);
+
+            for(Predictor predictor : {base ? Predictor::Base : Predictor::Previous, Predictor::None})
+            {
+                u64 size = 0;
+
+                for(u64 i = 0; i < n; i++)
+                    for(u64 k = 0; k < width; k++)
+                        shuffled[k * n + i] = in[i * width + k] ^ predict(predictor, in, reference, i, k, width);
+
+                for(u64 k = 0; k < width; k++)
+                {
+                    trial[k].clear();
+                    encode_plane(shuffled + k * n, n, trial[k]);
+                    size += trial[k].size();
+                }
+
+                if(size < best)
+                {
+                    best = size;
+                    predictors[b] = predictor;
+
+                    for(u64 k = 0; k < width; k++)
+                        std::swap(coded[b * width + k], trial[k]);
+                }
+            }
+        }
+    });
+
+    const u64 at = out.size();
+    auto put = [&out](u64 value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    put(0);
+    put(count);
+    put(width);
+    put(COMPRESS_BLOCK_VALUES);
+
+    for(u64 b = 0; b < blocks; b++)
+    {
+        out.push_back(static_cast<char>(predictors[b]));
+
+        for(u64 k = 0; k < width; k++)
+        {
+            const u32 size = static_cast<u32>(coded[b * width + k].size());
+            out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        }
+    }
+
+    for(const std::string& plane : coded)
+        out += plane;
+
+    const u64 size = out.size() - at - sizeof(u64);
+    std::memcpy(out.data() + at, &size, sizeof(size));
+}
+
+bool decompress_values(const char*& source, u64 available, const char* base, std::string& values, u64 count, u64 width)
+{
+    u64 header[4];
+
+    if(available < sizeof(header))
+        return false;
+
+    std::memcpy(header, source, sizeof(header));
+
+    const u64 size = header[0], block = header[3];
+    const u64 entry = 1 + width * sizeof(u32);
+
+    /* Blocks are never larger than the encoder makes them, so that the directory, which must fit in the payload,
+     * bounds the count before anything is allocated for it. */
+    if(size < 3 * sizeof(u64) || size > available - sizeof(u64) || header[1] != count || header[2] != width
+        || width == 0 || block == 0 || block > COMPRESS_BLOCK_VALUES)
+        return false;
+
+    const u64 blocks = count / block + (count % block != 0);
+
+    if(blocks > (size - 3 * sizeof(u64)) / entry || count > ~u64(0) / width)
+        return false;
+
+    const char* directory = source + sizeof(header);
+    cvector<Predictor> predictors(blocks);
+    cvector<u64> offsets(blocks * width + 1);
+    offsets[0] = sizeof(header) + blocks * entry;
+
+    for(u64 b = 0; b < blocks; b++)
+    {
+        const u8 predictor = static_cast<u8>(directory[b * entry]);
+
+        if(predictor > static_cast<u8>(Predictor::Base) || (predictor == static_cast<u8>(Predictor::Base) && !base))
+            return false;
+
+        predictors[b] = static_cast<Predictor>(predictor);
+
+        for(u64 k = 0; k < width; k++)
+        {
+            u32 plane;
+            std::memcpy(&plane, directory + b * entry + 1 + k * sizeof(u32), sizeof(plane));
+            offsets[b * width + k + 1] = offsets[b * width + k] + plane;
+        }
+    }
+
+    if(offsets.back() != size + sizeof(u64))
+        return false;
+
+    values.resize(count * width);
+
+    std::atomic<bool> valid(true);
+
+    parallel_for(blocks, 1, [&](u64 begin, u64 end)
+    {
+        std::string planes;
+
+        for(u64 b = begin; b < end && valid; b++)
+        {
+            const u64 first = b * block;
+            const u64 n = std::min<u64>(block, count - first);
+            u8* out = reinterpret_cast<u8*>(values.data()) + first * width;
+            const u8* reference = base ? reinterpret_cast<const u8*>(base) + first * width : nullptr;
+
+            planes.resize(n * width);
+            u8* shuffled = reinterpret_cast<u8*>(planes.data());
+
+            for(u64 k = 0; k < width; k++)
+            {
+                const u64 p = b * width + k;
+
+                if(!decode_plane(reinterpret_cast<const u8*>(source) + offsets[p], offsets[p + 1] - offsets[p],
+                                 shuffled + k * n, n))
+                {
+                    valid = false;
+                    return;
+                }
+            }
+
+            for(u64 i = 0; i < n; i++)
+                for(u64 k = 0; k < width; k++)
+                    out[i * width + k] = shuffled[k * n + i] ^ predict(predictors[b], out, reference, i, k, width);
+        }
+    });
+
+    source += size + sizeof(u64);
+    return valid;
+}
@@ -0,0 +1,645 @@
+#include <xorai/distributed.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <netdb.h>
+#include <algorithm>
+#include <cstring>
+
+/* How long a worker keeps retrying to reach a server that is not listening yet. */
+#define CONNECT_ATTEMPTS 100
+#define CONNECT_RETRY_MS 50
+
+/* Anything with a `/` is a Unix-domain socket path, anything else a TCP `host:port`. */
+static bool is_unix_address(const std::string& address)
+{
+    return address.find('/') != std::string::npos;
+}
+
+static sockaddr_un unix_address(const std::string& path)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if(path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "[C++ Distributed]: Socket path is too long: `" << path << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+/* Resolves a TCP `host:port`; an empty host listens on every interface. */
+static addrinfo* tcp_address(const std::string& address, bool passive)
+{
+    const u64 colon = address.rfind(':');
+    addrinfo hints {}, *result = nullptr;
+
+    if(colon == std::string::npos)
+    {
+        std::cout << "[C++ Distributed]: Expected a socket path or `host:port`, got `" << address << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+    if(i32 error = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result))
+    {
+        std::cout << "[C++ Distributed]: Failed to resolve `" << address << "`: " << ::gai_strerror(error) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return result;
+}
+
+/* Small messages (commits, single layers) must not wait for Nagle's algorithm. */
+static void set_no_delay(i32 fd)
+{
+    i32 enable = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+i32 listen_socket(const std::string& address)
+{
+    i32 fd = -1;
+
+    if(is_unix_address(address))
+    {
+        sockaddr_un local = unix_address(address);
+        ::unlink(address.c_str());
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if(fd >= 0 && (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0
+            || ::listen(fd, SOMAXCONN) < 0))
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    else
+    {
+        addrinfo* result = tcp_address(address, true);
+
+        for(addrinfo* info = result; info && fd < 0; info = info->ai_next)
+        {
+            i32 reuse = 1;
+            fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+
+            if(fd < 0)
+                continue;
+
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            if(::bind(fd, info->ai_addr, info->ai_addrlen) < 0 || ::listen(fd, SOMAXCONN) < 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+
+        ::freeaddrinfo(result);
+    }
+
+    if(fd < 0)
+    {
+        std::cout << "[C++ Distributed]: Failed to listen on `" << address << "`\n";
+        std::cout << "[!] " << std::strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    return fd;
+}
+
+/* Connects to `address`, retrying for a while so workers can be started alongside the server. */
+i32 connect_socket(const std::string& address)
+{
+    for(u64 attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++)
+    {
+        i32 fd = -1;
+
+        if(is_unix_address(address))
+        {
+            sockaddr_un remote = unix_address(address);
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+            if(fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) < 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        else
+        {
+            addrinfo* result = tcp_address(address, false);
+
+            for(addrinfo* info = result; info && fd < 0; info = info->ai_next)
+            {
+                fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+
+                if(fd >= 0 && ::connect(fd, info->ai_addr, info->ai_addrlen) < 0)
+                {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+
+            ::freeaddrinfo(result);
+
+            if(fd >= 0)
+                set_no_delay(fd);
+        }
+
+        if(fd >= 0)
+            return fd;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_MS));
+    }
+
+    std::cout << "[C++ Distributed]: Failed to connect to `" << address << "`\n";
+    std::cout << "[!] " << std::strerror(errno) << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/* Start of each layer's weights in the flattened parameters, followed by the total size. */
+template<typename Float>
+static cvector<u64> parameter_offsets(const Network<Float>& network)
+{
+    cvector<u64> offsets(network.weights.size() + 1, 0);
+
+    for(u64 i = 0; i < network.weights.size(); i++)
+        offsets[i + 1] = offsets[i] + network.weights[i].data.size() + network.biases[i].data.size();
+
+    return offsets;
+}
+
+/* Overwrites the weights and biases of `layer` with `values`, keeping a pruned layer's sparse copy in step. */
+template<typename Float>
+static void load_layer(Network<Float>& network, u64 layer, const Float* values)
+{
+    Matrix<Float>& weights = network.weights[layer];
+    Matrix<Float>& biases = network.biases[layer];
+
+    weights.data.detach(false);
+    biases.data.detach(false);
+
+    std::copy_n(values, weights.data.size(), weights.data.data());
+    std::copy_n(values + weights.data.size(), biases.data.size(), biases.data.data());
+
+    if(layer < network.sparse.size() && !network.sparse[layer].empty())
+        network.sparse[layer].mask(weights);
+
+    network.invalidate();
+}
+
+template<typename Float>
+ParameterServer<Float>::ParameterServer(Network<Float>& network, std::string address, u64 workers, u64 staleness)
+    : address(std::move(address)), workers(std::max<u64>(workers, 1)), staleness(staleness), version(0),
+      network(network), offsets(parameter_offsets(network)), sum(this->offsets.back(), Float(0))
+{
+    this->listener = listen_socket(this->address);
+}
+
+template<typename Float>
+ParameterServer<Float>::~ParameterServer()
+{
+    ::close(this->listener);
+
+    if(is_unix_address(this->address))
+        ::unlink(this->address.c_str());
+}
+
+/* Waits for all the workers to connect, so that they start from the same parameters,
+ * then serves them until every one of them has left. */
+template<typename Float>
+void ParameterServer<Float>::run()
+{
+    while(this->connections.size() < this->workers)
+    {
+        i32 fd = ::accept(this->listener, nullptr, nullptr);
+
+        if(fd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            std::cout << "[C++ Distributed]: Failed to accept a worker: " << std::strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        if(!is_unix_address(this->address))
+            set_no_delay(fd);
+
+        this->connections.emplace_back(fd);
+    }
+
+    cvector<std::thread> threads;
+
+    for(Connection& connection : this->connections)
+    {
+        if(this->staleness)
+            connection.delta.assign(this->offsets.back(), Float(0));
+
+        threads.emplace_back(&ParameterServer<Float>::serve_connection, this, std::ref(connection));
+    }
+
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+template<typename Float>
+void ParameterServer<Float>::serve_connection(Connection& connection)
+{
+    ParameterHeader header {};
+    cvector<Float> values;
+    cvector<Reply> replies;
+
+    while(read_exact(connection.fd, &header, sizeof(header)))
+    {
+        if(header.width != sizeof(Float))
+        {
+            std::cout << "[C++ Distributed]: A worker sent " << static_cast<u32>(header.width) << "-byte floats, expected "
+                      << sizeof(Float) << std::endl;
+            break;
+        }
+
+        if(header.op == ParameterOp::Hello)
+        {
+            std::lock_guard<std::mutex> lock(this->lock);
+            replies.push_back({&connection, parameters(connection)});
+        }
+        else if(header.op == ParameterOp::Delta)
+        {
+            if(header.layer + 1 >= this->offsets.size()
+                || header.count != this->offsets[header.layer + 1] - this->offsets[header.layer])
+                break;
+
+            values.resize(header.count);
+
+            if(!read_exact(connection.fd, values.data(), header.count * sizeof(Float)))
+                break;
+
+            std::lock_guard<std::mutex> lock(this->lock);
+            Float* target = (this->staleness ? connection.delta.data() : this->sum.data()) + this->offsets[header.layer];
+
+            for(u64 i = 0; i < header.count; i++)
+                target[i] += values[i];
+        }
+        else if(header.op == ParameterOp::Commit)
+        {
+            std::lock_guard<std::mutex> lock(this->lock);
+            commit(connection, replies);
+        }
+        else
+            break;
+
+        for(Reply& reply : replies)
+        {
+            std::lock_guard<std::mutex> lock(reply.connection->write_lock);
+            write_exact(reply.connection->fd, reply.message.data(), reply.message.size());
+        }
+
+        replies.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->lock);
+        leave(connection, replies);
+    }
+
+    for(Reply& reply : replies)
+    {
+        std::lock_guard<std::mutex> lock(reply.connection->write_lock);
+        write_exact(reply.connection->fd, reply.message.data(), reply.message.size());
+    }
+}
+
+/* Ends a worker's step. Synchronous steps wait for every active worker before the summed deltas
+ * are applied; asynchronous ones are applied right away. */
+template<typename Float>
+void ParameterServer<Float>::commit(Connection& connection, cvector<Reply>& replies)
+{
+    connection.clock++;
+
+    if(this->staleness == 0)
+    {
+        connection.committed = true;
+        release(replies);
+        return;
+    }
+
+    apply(connection.delta);
+    connection.deferred = true;
+    release(replies);
+}
+
+template<typename Float>
+void ParameterServer<Float>::leave(Connection& connection, cvector<Reply>& replies)
+{
+    connection.active = false;
+    connection.committed = false;
+    connection.deferred = false;
+
+    release(replies);
+}
+
+/* Adds `delta` to the network's parameters and clears it. */
+template<typename Float>
+void ParameterServer<Float>::apply(cvector<Float>& delta)
+{
+    std::unique_lock<SharedMutex> lock(this->network.guard);
+    cvector<Float> values(this->offsets.back());
+
+    for(u64 i = 0; i + 1 < this->offsets.size(); i++)
+    {
+        const Matrix<Float>& weights = this->network.weights[i];
+        const Matrix<Float>& biases = this->network.biases[i];
+        Float* layer = values.data() + this->offsets[i];
+
+        for(u64 j = 0; j < weights.data.size(); j++)
+            layer[j] = weights.data[j] + delta[this->offsets[i] + j];
+
+        for(u64 j = 0; j < biases.data.size(); j++)
+            layer[weights.data.size() + j] = biases.data[j] + delta[this->offsets[i] + weights.data.size() + j];
+
+        load_layer(this->network, i, layer);
+    }
+
+    std::fill(delta.begin(), delta.end(), Float(0));
+    this->version++;
+}
+
+/* Answers the workers that may go on:
+ *   - synchronous: all of them, once every active worker has committed the step.
+ *   - asynchronous: those at most `staleness` steps ahead of the slowest active worker. */
+template<typename Float>
+void ParameterServer<Float>::release(cvector<Reply>& replies)
+{
+    if(this->staleness == 0)
+    {
+        bool waiting = false, committed = false;
+
+        for(const Connection& connection : this->connections)
+        {
+            waiting |= connection.active && !connection.committed;
+            committed |= connection.committed;
+        }
+
+        if(waiting || !committed)
+            return;
+
+        apply(this->sum);
+
+        for(Connection& connection : this->connections)
+        {
+            if(connection.committed)
+                replies.push_back({&connection, parameters(connection)});
+
+            connection.committed = false;
+        }
+
+        return;
+    }
+
+    u64 slowest = UINT64_MAX;
+
+    for(const Connection& connection : this->connections)
+        if(connection.active)
+            slowest = std::min(slowest, connection.clock);
+
+    for(Connection& connection : this->connections)
+    {
+        if(!connection.deferred || (connection.clock > slowest && connection.clock - slowest > this->staleness))
+            continue;
+
+        connection.deferred = false;
+        replies.push_back({&connection, parameters(connection)});
+    }
+}
+
+/* The current parameters as a `Parameters` message for `connection`. */
+template<typename Float>
+cvector<u8> ParameterServer<Float>::parameters(const Connection& connection) const
+{
+    ParameterHeader header {ParameterOp::Parameters, sizeof(Float), 0, this->offsets.back(), this->version,
+                            connection.clock, this->staleness};
+    cvector<u8> message(sizeof(header) + header.count * sizeof(Float));
+
+    std::memcpy(message.data(), &header, sizeof(header));
+    auto* values = reinterpret_cast<Float*>(message.data() + sizeof(header));
+
+    for(u64 i = 0; i + 1 < this->offsets.size(); i++)
+    {
+        const Matrix<Float>& weights = this->network.weights[i];
+        const Matrix<Float>& biases = this->network.biases[i];
+
+        std::copy_n(weights.data.data(), weights.data.size(), values + this->offsets[i]);
+        std::copy_n(biases.data.data(), biases.data.size(), values + this->offsets[i] + weights.data.size());
+    }
+
+    return message;
+}
+
+/* Joins the job at `address` and replaces the parameters of `network` with the server's. */
+template<typename Float>
+Worker<Float>::Worker(Network<Float>& network, const std::string& address)
+    : staleness(0), steps(0), version(0), network(network), offsets(parameter_offsets(network)),
+      fd(connect_socket(address)), closing(false)
+{
+    this->sender = std::thread(&Worker<Float>::send_loop, this);
+
+    send(ParameterOp::Hello);
+    receive();
+}
+
+/* Leaves the job once every queued message has been sent. */
+template<typename Float>
+Worker<Float>::~Worker()
+{
+    send(ParameterOp::Bye);
+
+    {
+        std::lock_guard<std::mutex> lock(this->queue_lock);
+        this->closing = true;
+    }
+
+    this->queue_ready.notify_all();
+    this->sender.join();
+
+    ::close(this->fd);
+}
+
+/* Trains on this worker's shard for `epochs` passes, `batch` samples per step, and returns once
+ * the server has acknowledged every step, with the network holding the server's parameters. */
+template<typename Float>
+void Worker<Float>::train(Dataset<Float>& inputs, Dataset<Float>& targets, u64 epochs, u64 batch)
+{
+    assert(inputs.size() == targets.size());
+
+    batch = std::max<u64>(batch, 1);
+    matrix_t x(this->network.layers.front(), batch), y(this->network.layers.back(), batch);
+
+    for(u64 epoch = 0; epoch < epochs; epoch++)
+    {
+        for(u64 first = 0; first < inputs.size(); first += batch)
+        {
+            const u64 count = std::min<u64>(batch, inputs.size() - first);
+
+            for(u64 j = 0; j < count; j++)
+            {
+                for(u64 r = 0; r < x.rows; r++)
+                    x.data[r * batch + j] = inputs[first + j][r];
+
+                for(u64 r = 0; r < y.rows; r++)
+                    y.data[r * batch + j] = targets[first + j][r];
+            }
+
+            step(x.view().col_range(0, count), y.view().col_range(0, count));
+        }
+    }
+
+    while(!this->pending.empty())
+        receive();
+}
+
+/* One local gradient step. Each layer's change is queued as soon as backpropagation has produced it. */
+template<typename Float>
+void Worker<Float>::step(MatrixView<const Float> inputs, MatrixView<const Float> targets)
+{
+    {
+        std::unique_lock<SharedMutex> lock(this->network.guard);
+
+        this->current.assign(this->offsets.back(), Float(0));
+
+        /* A layer's delta is its parameters after the update minus those before. */
+        this->network.fit_batch(inputs, targets, [this](u64 layer, bool updated)
+        {
+            const matrix_t& weights = this->network.weights[layer];
+            const matrix_t& biases = this->network.biases[layer];
+            const Float sign = updated ? Float(1) : Float(-1);
+            Float* delta = this->current.data() + this->offsets[layer];
+
+            for(u64 j = 0; j < weights.data.size(); j++)
+                delta[j] += sign * weights.data[j];
+
+            for(u64 j = 0; j < biases.data.size(); j++)
+                delta[weights.data.size() + j] += sign * biases.data[j];
+
+            if(updated)
+                send(ParameterOp::Delta, layer, delta, this->offsets[layer + 1] - this->offsets[layer]);
+        });
+    }
+
+    send(ParameterOp::Commit);
+
+    this->steps++;
+    this->pending.push_back(std::move(this->current));
+
+    /* Answers that already arrived are cheap to take; past the staleness bound, wait for them. */
+    pollfd ready {this->fd, POLLIN, 0};
+
+    while(!this->pending.empty() && ::poll(&ready, 1, 0) > 0)
+        receive();
+
+    while(this->pending.size() > this->staleness)
+        receive();
+}
+
+/* Reads one `Parameters` message and adopts it, replaying the local steps the server has not seen yet. */
+template<typename Float>
+void Worker<Float>::receive()
+{
+    ParameterHeader header {};
+
+    if(!read_exact(this->fd, &header, sizeof(header)) || header.op != ParameterOp::Parameters
+        || header.width != sizeof(Float) || header.count != this->offsets.back())
+    {
+        std::cout << "[C++ Distributed]: Lost the parameter server, or it serves a different network" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    cvector<Float> values(header.count);
+
+    if(!read_exact(this->fd, values.data(), header.count * sizeof(Float)))
+    {
+        std::cout << "[C++ Distributed]: Lost the parameter server" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const u64 acknowledged = this->steps - this->pending.size();
+
+    this->staleness = header.staleness;
+
+    /* Answers to different steps may be sent by different server threads and overtake each other. */
+    if(header.clock < acknowledged || (header.clock == acknowledged && header.version < this->version))
+        return;
+
+    for(u64 i = acknowledged; i < header.clock; i++)
+        this->pending.pop_front();
+
+    for(const cvector<Float>& delta : this->pending)
+        for(u64 i = 0; i < values.size(); i++)
+            values[i] += delta[i];
+
+    std::unique_lock<SharedMutex> lock(this->network.guard);
+
+    for(u64 i = 0; i + 1 < this->offsets.size(); i++)
+        load_layer(this->network, i, values.data() + this->offsets[i]);
+
+    this->version = header.version;
+}
+
+/* Queues a message for the sender thread, copying the values. */
+template<typename Float>
+void Worker<Float>::send(ParameterOp op, u32 layer, const Float* values, u64 count)
+{
+    ParameterHeader header {op, sizeof(Float), layer, count, this->version, this->steps, this->staleness};
+    cvector<u8> message(sizeof(header) + count * sizeof(Float));
+
+    std::memcpy(message.data(), &header, sizeof(header));
+
+    if(count > 0)
+        std::memcpy(message.data() + sizeof(header), values, count * sizeof(Float));
+
+    {
+        std::lock_guard<std::mutex> lock(this->queue_lock);
+        this->queue.push_back(std::move(message));
+    }
+
+    this->queue_ready.notify_one();
+}
+
+template<typename Float>
+void Worker<Float>::send_loop()
+{
+    while(true)
+    {
+        cvector<u8> message;
+
+        {
+            std::unique_lock<std::mutex> lock(this->queue_lock);
+            this->queue_ready.wait(lock, [this] { return this->closing || !this->queue.empty(); });
+
+            if(this->queue.empty())
+                return;
+
+            message = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+
+        if(!write_exact(this->fd, message.data(), message.size()))
+        {
+            std::cout << "[C++ Distributed]: Failed to reach the parameter server: " << std::strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+INSTANTIATE_CLASS_FLOATS(ParameterServer)
+INSTANTIATE_CLASS_FLOATS(Worker)
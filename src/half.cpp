@@ -0,0 +1,223 @@
+#include <xorai/half.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HALF_X86_KERNELS
+#endif
+
+/* Independent sums of the portable dot products, so that the loops vectorize. */
+#define HALF_DOT_LANES 16
+
+#ifdef HALF_X86_KERNELS
+/* The vector kernels are compiled for the instructions they need and picked at run time,
+ * so that builds for generic x86-64 use them too. */
+static bool has_f16c()
+{
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"));
+    return supported;
+}
+
+static bool has_avx2()
+{
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+}
+
+static bool has_avx512_bf16()
+{
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx512vl")
+                                   && __builtin_cpu_supports("avx512bf16"));
+    return supported;
+}
+
+__attribute__((target("avx,f16c")))
+static u64 widen_f16c(const f16* in, f32* out, u64 count)
+{
+    u64 i = 0;
+
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static u64 narrow_f16c(const f32* in, f16* out, u64 count)
+{
+    u64 i = 0;
+
+    for(; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+
+    return i;
+}
+
+__attribute__((target("avx512f,avx512vl,avx512bf16")))
+static u64 narrow_avx512_bf16(const f32* in, bf16* out, u64 count)
+{
+    u64 i = 0;
+
+    const __m256i exponent = _mm256_set1_epi32(0x7f800000), mantissa = _mm256_set1_epi32(0x007fffff);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m256 values = _mm256_loadu_ps(in + i);
+        const __m256i bits = _mm256_castps_si256(values);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), (__m128i) _mm256_cvtneps_pbh(values));
+
+        /* The instruction flushes subnormal inputs to zero; those lanes are rounded like `bf16::narrow` instead,
+         * so that results do not depend on the CPU or on where a value falls in the array. */
+        const u32 subnormal = _mm256_testn_epi32_mask(bits, exponent) & _mm256_test_epi32_mask(bits, mantissa);
+
+        for(u32 lane = 0; subnormal >> lane; lane++)
+            if(subnormal >> lane & 1)
+                out[i + lane] = bf16(in[i + lane]);
+    }
+
+    return i;
+}
+
+/* Sums 16 products per iteration in two vectors; returns the sum and leaves the tail to the caller. */
+__attribute__((target("avx,f16c")))
+static f32 dot_f16c(const f16* a, const f32* b, u64 count, u64& done)
+{
+    __m256 low = _mm256_setzero_ps(), high = _mm256_setzero_ps();
+    u64 i = 0;
+
+    for(; i + 16 <= count; i += 16)
+    {
+        __m256 x = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        __m256 y = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 8)));
+
+        low = _mm256_add_ps(low, _mm256_mul_ps(x, _mm256_loadu_ps(b + i)));
+        high = _mm256_add_ps(high, _mm256_mul_ps(y, _mm256_loadu_ps(b + i + 8)));
+    }
+
+    alignas(32) f32 lanes[8];
+    _mm256_store_ps(lanes, _mm256_add_ps(low, high));
+
+    done = i;
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+/* A bf16 widens by shifting its bits into the upper half of an f32. */
+__attribute__((target("avx2")))
+static f32 dot_avx2_bf16(const bf16* a, const f32* b, u64 count, u64& done)
+{
+    __m256 low = _mm256_setzero_ps(), high = _mm256_setzero_ps();
+    u64 i = 0;
+
+    for(; i + 16 <= count; i += 16)
+    {
+        __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256 x = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(bits)), 16));
+        __m256 y = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(bits, 1)), 16));
+
+        low = _mm256_add_ps(low, _mm256_mul_ps(x, _mm256_loadu_ps(b + i)));
+        high = _mm256_add_ps(high, _mm256_mul_ps(y, _mm256_loadu_ps(b + i + 8)));
+    }
+
+    alignas(32) f32 lanes[8];
+    _mm256_store_ps(lanes, _mm256_add_ps(low, high));
+
+    done = i;
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+#endif
+
+template<typename Half>
+static f32 portable_dot(const Half* a, const f32* b, u64 count)
+{
+    f32 lanes[HALF_DOT_LANES] = {};
+    u64 i = 0;
+
+    for(; i + HALF_DOT_LANES <= count; i += HALF_DOT_LANES)
+        for(u64 l = 0; l < HALF_DOT_LANES; l++)
+            lanes[l] += static_cast<f32>(a[i + l]) * b[i + l];
+
+    for(; i < count; i++)
+        lanes[0] += static_cast<f32>(a[i]) * b[i];
+
+    for(u64 width = HALF_DOT_LANES / 2; width > 0; width /= 2)
+        for(u64 l = 0; l < width; l++)
+            lanes[l] += lanes[l + width];
+
+    return lanes[0];
+}
+
+void widen(const f16* in, f32* out, u64 count)
+{
+    u64 i = 0;
+
+#ifdef HALF_X86_KERNELS
+    if(has_f16c())
+        i = widen_f16c(in, out, count);
+#endif
+
+    for(; i < count; i++)
+        out[i] = static_cast<f32>(in[i]);
+}
+
+void widen(const bf16* in, f32* out, u64 count)
+{
+    for(u64 i = 0; i < count; i++)
+        out[i] = static_cast<f32>(in[i]);
+}
+
+void narrow(const f32* in, f16* out, u64 count)
+{
+    u64 i = 0;
+
+#ifdef HALF_X86_KERNELS
+    if(has_f16c())
+        i = narrow_f16c(in, out, count);
+#endif
+
+    for(; i < count; i++)
+        out[i] = f16(in[i]);
+}
+
+void narrow(const f32* in, bf16* out, u64 count)
+{
+    u64 i = 0;
+
+#ifdef HALF_X86_KERNELS
+    if(has_avx512_bf16())
+        i = narrow_avx512_bf16(in, out, count);
+#endif
+
+    for(; i < count; i++)
+        out[i] = bf16(in[i]);
+}
+
+f32 dot(const f16* a, const f32* b, u64 count)
+{
+#ifdef HALF_X86_KERNELS
+    if(has_f16c())
+    {
+        u64 done = 0;
+        f32 sum = dot_f16c(a, b, count, done);
+
+        return sum + portable_dot(a + done, b + done, count - done);
+    }
+#endif
+
+    return portable_dot(a, b, count);
+}
+
+f32 dot(const bf16* a, const f32* b, u64 count)
+{
+#ifdef HALF_X86_KERNELS
+    if(has_avx2())
+    {
+        u64 done = 0;
+        f32 sum = dot_avx2_bf16(a, b, count, done);
+
+        return sum + portable_dot(a + done, b + done, count - done);
+    }
+#endif
+
+    return portable_dot(a, b, count);
+}
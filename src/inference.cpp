@@ -0,0 +1,415 @@
+#include <xorai/activation.h>
+#include <xorai/inference.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#define matrix_t Matrix<Float>
+
+/* Alignment of the packed storage and of every layer inside it, one cache line. */
+#define INFERENCE_ALIGNMENT 64
+
+template<typename Float>
+InferenceModel<Float>::InferenceModel(const U64Array& layers, const MatrixArray<Float>& weights,
+                                      const MatrixArray<Float>& biases, const ActivationArray& activations,
+                                      Accumulation accumulation)
+    : layers(layers), activations(activations), accumulation(accumulation), storage(nullptr)
+{
+    pack(weights, biases);
+}
+
+/* Loads only the layers, weights, biases and activation functions of a model file;
+ * any stored activations of the last sample are skipped. */
+template<typename Float>
+InferenceModel<Float>::InferenceModel(std::string filename)
+    : accumulation(Accumulation::Naive), storage(nullptr)
+{
+    ModelViewer<Float> viewer(std::move(filename));
+    Model<Float> model = viewer.load(false);
+
+    this->layers = std::move(model.layers);
+    this->activations = std::move(model.activations);
+    pack(model.weights, model.biases);
+}
+
+template<typename Float>
+InferenceModel<Float>::InferenceModel(InferenceModel&& other) noexcept
+    : layers(std::move(other.layers)), activations(std::move(other.activations)),
+      accumulation(other.accumulation), kernels(std::move(other.kernels)), storage(other.storage),
+      weight_offsets(std::move(other.weight_offsets)), bias_offsets(std::move(other.bias_offsets))
+{
+    other.storage = nullptr;
+}
+
+template<typename Float>
+InferenceModel<Float>::~InferenceModel()
+{
+    std::free(this->storage);
+}
+
+template<typename Float>
+InferenceModel<Float>& InferenceModel<Float>::operator=(InferenceModel&& other) noexcept
+{
+    if(this != &other)
+    {
+        std::free(this->storage);
+
+        this->layers = std::move(other.layers);
+        this->activations = std::move(other.activations);
+        this->accumulation = other.accumulation;
+        this->kernels = std::move(other.kernels);
+        this->storage = other.storage;
+        this->weight_offsets = std::move(other.weight_offsets);
+        this->bias_offsets = std::move(other.bias_offsets);
+
+        other.storage = nullptr;
+    }
+
+    return *this;
+}
+
+/* Runs a forward pass over one sample per column of `inputs`. */
+template<typename Float>
+matrix_t InferenceModel<Float>::predict(const matrix_t& inputs) const
+{
+    assert(this->layers[0] == inputs.rows);
+
+    const u64 batch = inputs.cols;
+    matrix_t current = inputs;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1];
+        const u64 cols = this->layers[i];
+        const Float* w = weights(i);
+        const Float* b = biases(i);
+
+        matrix_t next(rows, batch);
+
+        gemm(w, current.data.data(), next.data.data(), rows, cols, batch, this->accumulation,
+             i < this->kernels.size() ? this->kernels[i] : GemmConfig());
+
+        activate(this->activations[i], next.data.data(), b, rows, batch);
+
+        current = std::move(next);
+    }
+
+    return current;
+}
+
+template<typename Float>
+matrix_t InferenceModel<Float>::test(Float a, Float b) const
+{
+    return predict(matrix_t::from({a, b}));
+}
+
+/* Writes an inference-only model file, which both `InferenceModel` and `Network` can load. */
+template<typename Float>
+void InferenceModel<Float>::save(std::string filename, i8 float_precision) const
+{
+    ModelViewer<Float> viewer(std::move(filename), float_precision);
+    MatrixArray<Float> weights, biases;
+    Json::Value model;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+
+        weights.push_back(matrix_t(rows, cols, cvector<Float>(this->weights(i), this->weights(i) + rows * cols)));
+        biases.push_back(matrix_t(rows, 1, cvector<Float>(this->biases(i), this->biases(i) + rows)));
+    }
+
+    model["b"] = viewer.jsonify(biases);
+    model["w"] = viewer.jsonify(weights);
+    model["l"] = viewer.jsonify(this->layers);
+    model["a"] = viewer.jsonify(this->activations);
+
+    viewer.write(model);
+}
+
+/* Picks the fastest matrix product settings for every layer at the given batch size, as `Network::tune` does. */
+template<typename Float>
+void InferenceModel<Float>::tune(KernelTuner& tuner, u64 batch)
+{
+    this->kernels.resize(this->layers.size() - 1);
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+        this->kernels[i] = tuner.tune<Float>(this->layers[i + 1], this->layers[i], batch, this->accumulation);
+}
+
+template<typename Float>
+const Float* InferenceModel<Float>::weights(u64 layer) const
+{
+    return this->storage + this->weight_offsets[layer];
+}
+
+template<typename Float>
+const Float* InferenceModel<Float>::biases(u64 layer) const
+{
+    return this->storage + this->bias_offsets[layer];
+}
+
+template<typename Float>
+u64 InferenceModel<Float>::parameters() const
+{
+    u64 count = 0;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+        count += this->layers[i + 1] * (this->layers[i] + 1);
+
+    return count;
+}
+
+/* Copies the weights and biases of every layer into one aligned allocation. */
+template<typename Float>
+void InferenceModel<Float>::pack(const MatrixArray<Float>& weights, const MatrixArray<Float>& biases)
+{
+    assert(weights.size() == this->layers.size() - 1 && biases.size() == weights.size());
+
+    const u64 line = std::max<u64>(INFERENCE_ALIGNMENT / sizeof(Float), 1);
+    auto align = [line](u64 count) { return (count + line - 1) / line * line; };
+
+    u64 offset = 0;
+
+    for(u64 i = 0; i < weights.size(); i++)
+    {
+        this->weight_offsets.push_back(offset);
+        offset += align(weights[i].data.size());
+
+        this->bias_offsets.push_back(offset);
+        offset += align(biases[i].data.size());
+    }
+
+    this->storage = static_cast<Float*>(std::aligned_alloc(INFERENCE_ALIGNMENT, std::max<u64>(offset, line) * sizeof(Float)));
+
+    if(this->storage == nullptr)
+    {
+        std::cout << "[C++ InferenceModel]: Failed to allocate " << offset * sizeof(Float) << " bytes." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::fill(this->storage, this->storage + offset, Float(0.0));
+
+    for(u64 i = 0; i < weights.size(); i++)
+    {
+        std::copy(weights[i].data.begin(), weights[i].data.end(), this->storage + this->weight_offsets[i]);
+        std::copy(biases[i].data.begin(), biases[i].data.end(), this->storage + this->bias_offsets[i]);
+    }
+}
+
+template<typename Half>
+HalfModel<Half>::HalfModel(const U64Array& layers, const MatrixArray<f32>& weights, const MatrixArray<f32>& biases,
+                           const ActivationArray& activations)
+    : layers(layers), activations(activations), storage(nullptr)
+{
+    pack(weights, biases);
+}
+
+/* Loads a JSON or binary model file of any precision and rounds it to `Half`. */
+template<typename Half>
+HalfModel<Half>::HalfModel(std::string filename)
+    : storage(nullptr)
+{
+    ModelViewer<f32> viewer(std::move(filename));
+    Model<f32> model = viewer.load(false);
+
+    this->layers = std::move(model.layers);
+    this->activations = std::move(model.activations);
+    pack(model.weights, model.biases);
+}
+
+template<typename Half>
+HalfModel<Half>::HalfModel(HalfModel&& other) noexcept
+    : layers(std::move(other.layers)), activations(std::move(other.activations)), storage(other.storage),
+      weight_offsets(std::move(other.weight_offsets)), bias_offsets(std::move(other.bias_offsets))
+{
+    other.storage = nullptr;
+}
+
+template<typename Half>
+HalfModel<Half>::~HalfModel()
+{
+    std::free(this->storage);
+}
+
+template<typename Half>
+HalfModel<Half>& HalfModel<Half>::operator=(HalfModel&& other) noexcept
+{
+    if(this != &other)
+    {
+        std::free(this->storage);
+
+        this->layers = std::move(other.layers);
+        this->activations = std::move(other.activations);
+        this->storage = other.storage;
+        this->weight_offsets = std::move(other.weight_offsets);
+        this->bias_offsets = std::move(other.bias_offsets);
+
+        other.storage = nullptr;
+    }
+
+    return *this;
+}
+
+/* Runs a forward pass over one sample per column of `inputs`. */
+template<typename Half>
+Matrix<f32> HalfModel<Half>::predict(const Matrix<f32>& inputs) const
+{
+    assert(this->layers[0] == inputs.rows);
+
+    const u64 batch = inputs.cols;
+    Matrix<f32> current = inputs;
+    cvector<f32> bias;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1];
+        Matrix<f32> next(rows, batch);
+
+        multiply(i, current, next.view());
+
+        bias.resize(rows);
+        widen(biases(i), bias.data(), rows);
+        activate(this->activations[i], next.data.data(), bias.data(), rows, batch);
+
+        current = std::move(next);
+    }
+
+    return current;
+}
+
+template<typename Half>
+Matrix<f32> HalfModel<Half>::test(f32 a, f32 b) const
+{
+    return predict(Matrix<f32>::from({a, b}));
+}
+
+/* Writes a JSON model file that any model class can load. The default precision keeps every `f16` value. */
+template<typename Half>
+void HalfModel<Half>::save(std::string filename, i8 float_precision) const
+{
+    ModelViewer<f32> viewer(std::move(filename), float_precision);
+    Model<f32> model = unpack();
+    Json::Value json;
+
+    json["b"] = viewer.jsonify(model.biases);
+    json["w"] = viewer.jsonify(model.weights);
+    json["l"] = viewer.jsonify(model.layers);
+    json["a"] = viewer.jsonify(model.activations);
+
+    viewer.write(json);
+}
+
+/* Writes a binary model file, e.g. `Storage::F16` for an `f16` model at 2 bytes per parameter. */
+template<typename Half>
+void HalfModel<Half>::save(std::string filename, Storage storage) const
+{
+    ModelViewer<f32> viewer(std::move(filename));
+    viewer.write(unpack(), storage);
+}
+
+template<typename Half>
+const Half* HalfModel<Half>::weights(u64 layer) const
+{
+    return this->storage + this->weight_offsets[layer];
+}
+
+template<typename Half>
+const Half* HalfModel<Half>::biases(u64 layer) const
+{
+    return this->storage + this->bias_offsets[layer];
+}
+
+template<typename Half>
+u64 HalfModel<Half>::parameters() const
+{
+    u64 count = 0;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+        count += this->layers[i + 1] * (this->layers[i] + 1);
+
+    return count;
+}
+
+/* Rounds the weights and biases of every layer into one aligned allocation, laid out as `InferenceModel` does. */
+template<typename Half>
+void HalfModel<Half>::pack(const MatrixArray<f32>& weights, const MatrixArray<f32>& biases)
+{
+    assert(weights.size() == this->layers.size() - 1 && biases.size() == weights.size());
+
+    const u64 line = INFERENCE_ALIGNMENT / sizeof(Half);
+    auto align = [line](u64 count) { return (count + line - 1) / line * line; };
+
+    u64 offset = 0;
+
+    for(u64 i = 0; i < weights.size(); i++)
+    {
+        this->weight_offsets.push_back(offset);
+        offset += align(weights[i].data.size());
+
+        this->bias_offsets.push_back(offset);
+        offset += align(biases[i].data.size());
+    }
+
+    this->storage = static_cast<Half*>(std::aligned_alloc(INFERENCE_ALIGNMENT, std::max<u64>(offset, line) * sizeof(Half)));
+
+    if(this->storage == nullptr)
+    {
+        std::cout << "[C++ HalfModel]: Failed to allocate " << offset * sizeof(Half) << " bytes." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::fill(this->storage, this->storage + offset, Half(0.0f));
+
+    for(u64 i = 0; i < weights.size(); i++)
+    {
+        narrow(weights[i].data.data(), this->storage + this->weight_offsets[i], weights[i].data.size());
+        narrow(biases[i].data.data(), this->storage + this->bias_offsets[i], biases[i].data.size());
+    }
+}
+
+/* Writes `weights(layer) * inputs` to `outputs`. The weights are widened in registers as the dot products
+ * load them, so only their 16-bit form crosses the memory bus. */
+template<typename Half>
+void HalfModel<Half>::multiply(u64 layer, MatrixView<const f32> inputs, MatrixView<f32> outputs) const
+{
+    const u64 rows = this->layers[layer + 1], cols = this->layers[layer], batch = inputs.cols;
+    const Half* w = weights(layer);
+
+    /* One sample per row, so that each dot product reads both operands contiguously. */
+    cvector<f32> samples(batch * cols);
+
+    for(u64 k = 0; k < cols; k++)
+        for(u64 n = 0; n < batch; n++)
+            samples[n * cols + k] = inputs(k, n);
+
+    for(u64 r = 0; r < rows; r++)
+        for(u64 n = 0; n < batch; n++)
+            outputs(r, n) = dot(w + r * cols, samples.data() + n * cols, cols);
+}
+
+/* The parameters widened back to f32, for saving. */
+template<typename Half>
+Model<f32> HalfModel<Half>::unpack() const
+{
+    Model<f32> model;
+
+    model.layers = this->layers;
+    model.activations = this->activations;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+    {
+        const u64 rows = this->layers[i + 1], cols = this->layers[i];
+
+        model.weights.emplace_back(rows, cols);
+        model.biases.emplace_back(rows, 1);
+
+        widen(weights(i), model.weights.back().data.data(), rows * cols);
+        widen(biases(i), model.biases.back().data.data(), rows);
+    }
+
+    return model;
+}
+
+INSTANTIATE_CLASS_FLOATS(InferenceModel)
+INSTANTIATE_CLASS_HALVES(HalfModel)
\ No newline at end of file
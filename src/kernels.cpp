@@ -0,0 +1,257 @@
+#include <xorai/kernels.h>
+#include <xorai/parallel.h>
+
+#define INSTANTIATE_KERNEL_FLOATS(f, ...)                    \
+    template f32 f<f32>(const f32*, const f32*, __VA_ARGS__);    \
+    template f64 f<f64>(const f64*, const f64*, __VA_ARGS__);    \
+    template f128 f<f128>(const f128*, const f128*, __VA_ARGS__); \
+    template fdd f<fdd>(const fdd*, const fdd*, __VA_ARGS__);
+
+/* Independent accumulators per kernel; eight f32 lanes fill a 256-bit vector. */
+#define KERNEL_LANES 8
+
+/* Length below which pairwise summation falls back to lane sums. */
+#define PAIRWISE_BLOCK 128
+
+template<typename Float, u64 Lanes = KERNEL_LANES>
+static Float naive_sum(const Float* a, const Float* b, u64 count, u64 stride)
+{
+    Float lanes[Lanes] = {};
+    u64 k = 0;
+
+    if(stride == 1)
+        for(; k + Lanes <= count; k += Lanes)
+            for(u64 l = 0; l < Lanes; l++)
+                lanes[l] += a[k + l] * b[k + l];
+    else
+        for(; k + Lanes <= count; k += Lanes)
+            for(u64 l = 0; l < Lanes; l++)
+                lanes[l] += a[k + l] * b[(k + l) * stride];
+
+    for(; k < count; k++)
+        lanes[0] += a[k] * b[k * stride];
+
+    for(u64 width = Lanes / 2; width > 0; width /= 2)
+        for(u64 l = 0; l < width; l++)
+            lanes[l] += lanes[l + width];
+
+    return lanes[0];
+}
+
+template<typename Float>
+static Float pairwise_sum(const Float* a, const Float* b, u64 count, u64 stride)
+{
+    if(count <= PAIRWISE_BLOCK)
+        return naive_sum(a, b, count, stride);
+
+    /* Split on a multiple of the block size so that every leaf but the last is full. */
+    u64 half = ((count / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK) * PAIRWISE_BLOCK;
+    return pairwise_sum(a, b, half, stride) + pairwise_sum(a + half, b + half * stride, count - half, stride);
+}
+
+/* Kahan-Babuska-Neumaier summation. The rounding error of each addition is recovered
+ * exactly with Knuth's branch-free TwoSum instead of Neumaier's magnitude comparison,
+ * which gives the same result for either operand order and lets the lanes vectorize. */
+template<typename Float>
+static void accumulate(Float& sum, Float& error, Float term)
+{
+    Float total = sum + term;
+    Float virtual_term = total - sum;
+
+    error += (sum - (total - virtual_term)) + (term - virtual_term);
+    sum = total;
+}
+
+template<typename Float>
+static Float compensated_sum(const Float* a, const Float* b, u64 count, u64 stride)
+{
+    Float sums[KERNEL_LANES] = {};
+    Float errors[KERNEL_LANES] = {};
+    u64 k = 0;
+
+    if(stride == 1)
+        for(; k + KERNEL_LANES <= count; k += KERNEL_LANES)
+            for(u64 l = 0; l < KERNEL_LANES; l++)
+                accumulate(sums[l], errors[l], a[k + l] * b[k + l]);
+    else
+        for(; k + KERNEL_LANES <= count; k += KERNEL_LANES)
+            for(u64 l = 0; l < KERNEL_LANES; l++)
+                accumulate(sums[l], errors[l], a[k + l] * b[(k + l) * stride]);
+
+    for(; k < count; k++)
+        accumulate(sums[0], errors[0], a[k] * b[k * stride]);
+
+    Float sum = 0.0, error = 0.0;
+
+    for(u64 l = 0; l < KERNEL_LANES; l++)
+    {
+        accumulate(sum, error, sums[l]);
+        error += errors[l];
+    }
+
+    return sum + error;
+}
+
+template<typename Float>
+Float inner_product(const Float* a, const Float* b, u64 count, u64 stride, Accumulation accumulation)
+{
+    /* Double-doubles always use their own compensated kernel. */
+    if constexpr (std::is_same_v<Float, fdd>)
+        return fdd::dot(a, b, count, stride);
+
+    switch(accumulation)
+    {
+        case Accumulation::Pairwise: return pairwise_sum(a, b, count, stride);
+        case Accumulation::Kahan: return compensated_sum(a, b, count, stride);
+        default: return naive_sum(a, b, count, stride);
+    }
+}
+
+/* Computes rows [begin, end) of `c` tile by tile, so that a `block_k` x `block_j` tile of `b`
+ * stays in cache while every row of `a` is applied to it. */
+template<typename Float>
+static void gemm_blocked(MatrixView<const Float> a, MatrixView<const Float> b, MatrixView<Float> c, u64 begin, u64 end,
+                         u64 block_k, u64 block_j)
+{
+    for(u64 i = begin; i < end; i++)
+        std::fill(c.row(i), c.row(i) + c.cols, Float(0.0));
+
+    for(u64 kk = 0; kk < a.cols; kk += block_k)
+    {
+        const u64 k_end = std::min(a.cols, kk + block_k);
+
+        for(u64 jj = 0; jj < c.cols; jj += block_j)
+        {
+            const u64 j_end = std::min(c.cols, jj + block_j);
+
+            for(u64 i = begin; i < end; i++)
+            {
+                Float* row = c.row(i);
+
+                for(u64 k = kk; k < k_end; k++)
+                {
+                    const Float factor = a(i, k);
+                    const Float* source = b.row(k);
+
+                    for(u64 j = jj; j < j_end; j++)
+                        row[j] += factor * source[j];
+                }
+            }
+        }
+    }
+}
+
+template<typename Float>
+static void gemm_inner(MatrixView<const Float> a, MatrixView<const Float> b, MatrixView<Float> c, u64 begin, u64 end,
+                       Accumulation accumulation, u64 lanes)
+{
+    for(u64 i = begin; i < end; i++)
+    {
+        const Float* row = a.row(i);
+
+        for(u64 j = 0; j < c.cols; j++)
+        {
+            if constexpr (!std::is_same_v<Float, fdd>)
+            {
+                if(accumulation == Accumulation::Naive && lanes == 4)
+                {
+                    c(i, j) = naive_sum<Float, 4>(row, b.data + j, a.cols, b.stride);
+                    continue;
+                }
+                else if(accumulation == Accumulation::Naive && lanes == 16)
+                {
+                    c(i, j) = naive_sum<Float, 16>(row, b.data + j, a.cols, b.stride);
+                    continue;
+                }
+            }
+
+            c(i, j) = inner_product(row, b.data + j, a.cols, b.stride, accumulation);
+        }
+    }
+}
+
+template<typename Float>
+void gemm(const Float* a, const Float* b, Float* c, u64 rows, u64 inner, u64 cols,
+          Accumulation accumulation, const GemmConfig& config)
+{
+    gemm(MatrixView<const Float>(a, rows, inner), MatrixView<const Float>(b, inner, cols), MatrixView<Float>(c, rows, cols),
+         accumulation, config);
+}
+
+template<typename Float>
+void gemm(MatrixView<const Float> a, MatrixView<const Float> b, MatrixView<Float> c, Accumulation accumulation,
+          const GemmConfig& config)
+{
+    /* Tiling reorders the sums, which only the Naive mode allows; double-doubles keep their compensated dot. */
+    const bool blocked = config.strategy == GemmStrategy::Blocked && accumulation == Accumulation::Naive
+            && !std::is_same_v<Float, fdd>;
+
+    auto rows_of = [&](u64 begin, u64 end)
+    {
+        if(blocked)
+            gemm_blocked(a, b, c, begin, end, std::max<u64>(config.block_k, 1), std::max<u64>(config.block_j, 1));
+        else
+            gemm_inner(a, b, c, begin, end, accumulation, config.lanes);
+    };
+
+    if(config.threads > 1 && c.rows > 1)
+        parallel_for(c.rows, (c.rows + config.threads - 1) / config.threads, rows_of);
+    else
+        rows_of(0, c.rows);
+}
+
+template<typename Float>
+void transpose_gemm(MatrixView<const Float> a, MatrixView<const Float> b, MatrixView<Float> c)
+{
+    for(u64 i = 0; i < c.rows; i++)
+        std::fill(c.row(i), c.row(i) + c.cols, Float(0.0));
+
+    for(u64 k = 0; k < a.rows; k++)
+    {
+        const Float* row = a.row(k);
+
+        for(u64 j = 0; j < b.cols; j++)
+        {
+            const Float factor = b(k, j);
+
+            for(u64 i = 0; i < a.cols; i++)
+                c(i, j) += row[i] * factor;
+        }
+    }
+}
+
+/* For k = 1 this is the rank-1 outer product of the weight update, without materializing the product. */
+template<typename Float>
+void rank_update(Float scale, MatrixView<const Float> a, MatrixView<const Float> b, MatrixView<Float> c)
+{
+    for(u64 i = 0; i < c.rows; i++)
+    {
+        Float* row = c.row(i);
+
+        for(u64 p = 0; p < a.cols; p++)
+        {
+            const Float factor = scale * a(i, p);
+
+            if(a.cols == 1 && b.contiguous())
+                for(u64 j = 0; j < c.cols; j++)
+                    row[j] += factor * b.data[j];
+            else
+                for(u64 j = 0; j < c.cols; j++)
+                    row[j] += factor * b(j, p);
+        }
+    }
+}
+
+INSTANTIATE_KERNEL_FLOATS(inner_product, u64, u64, Accumulation)
+
+#define INSTANTIATE_VIEW_KERNELS(Float)                                                                          \
+    template void gemm<Float>(const Float*, const Float*, Float*, u64, u64, u64, Accumulation, const GemmConfig&);  \
+    template void gemm<Float>(MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>, Accumulation,   \
+                              const GemmConfig&);                                                                 \
+    template void transpose_gemm<Float>(MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>);      \
+    template void rank_update<Float>(Float, MatrixView<const Float>, MatrixView<const Float>, MatrixView<Float>);
+
+INSTANTIATE_VIEW_KERNELS(f32)
+INSTANTIATE_VIEW_KERNELS(f64)
+INSTANTIATE_VIEW_KERNELS(f128)
+INSTANTIATE_VIEW_KERNELS(fdd)
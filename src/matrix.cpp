@@ -1,7 +1,10 @@
+#include <xorai/parallel.h>
 #include <xorai/matrix.h>
+#include <xorai/random.h>
 #include <iostream>
 #include <cassert>
-#include <random>
+#include <limits>
+#include <cmath>
 
 #ifdef __F128_SUPPORT__
 extern "C" {
@@ -12,158 +15,187 @@ extern "C" {
 #define matrix_t Matrix<Float>
 
 template<typename Float>
-Matrix<Float>::Matrix(u64 rows, u64 cols, FloatArray& data)
-    : rows(rows), cols(cols), data(data)
+Matrix<Float>::Matrix()
+    : rows(0), cols(0)
 {
     assert_float_type();
-    assert(data.size() - 1 != rows * cols);
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::add(matrix_t* other)
+Matrix<Float>::Matrix(u64 rows, u64 cols)
+    : rows(rows), cols(cols), data(rows * cols, 0.0)
 {
-    assert(this->rows == other->rows && this->cols == other->cols);
+    assert_float_type();
+}
+
+template<typename Float>
+Matrix<Float>::Matrix(u64 rows, u64 cols, const FloatArray& data)
+    : rows(rows), cols(cols), data(data.begin(), data.end())
+{
+    assert_float_type();
+    assert(data.size() == rows * cols);
+}
 
-    FloatArray buffer = FloatArray::with_capacity(this->rows * this->cols)
-            .fill([this, other]BASIC_UNARY(i, this->data[i] + other->data[i]));
+/* Copies the elements of a view into a new dense matrix. */
+template<typename Float>
+Matrix<Float>::Matrix(MatrixView<const Float> view)
+    : rows(view.rows), cols(view.cols), data(view.rows * view.cols)
+{
+    assert_float_type();
 
-    check_destroy(other);
-    return make(buffer);
+    for(u64 r = 0; r < view.rows; r++)
+        std::copy_n(view.row(r), view.cols, this->data.data() + r * view.cols);
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::sub(matrix_t* other)
+matrix_t& Matrix<Float>::add(const matrix_t& other, Float scale)
 {
-    assert(this->rows == other->rows && cols == other->cols);
+    assert(this->rows == other.rows && this->cols == other.cols);
 
-    FloatArray buffer = FloatArray::with_capacity(this->rows * this->cols)
-            .fill([this, other]BASIC_UNARY(i, this->data[i] - other->data[i]));
+    this->data.detach();
+
+    for(u64 i = 0; i < this->data.size(); i++)
+        this->data[i] += scale * other.data[i];
 
-    check_destroy(other);
-    return make(buffer);
+    return *this;
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::mul(matrix_t* other)
+matrix_t& Matrix<Float>::sub(const matrix_t& other)
 {
-    assert(this->rows == other->rows && this->cols == other->cols);
+    assert(this->rows == other.rows && this->cols == other.cols);
 
-    FloatArray result(this->rows * this->cols, 0.0);
+    this->data.detach();
 
     for(u64 i = 0; i < this->data.size(); i++)
-        result[i] = this->data[i] * other->data[i];
+        this->data[i] -= other.data[i];
 
-    check_destroy(other);
-    return make(result);
+    return *this;
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::dot(matrix_t* other)
+matrix_t& Matrix<Float>::mul(const matrix_t& other)
 {
-    assert(this->cols == other->rows);
+    assert(this->rows == other.rows && this->cols == other.cols);
 
-    u64 i, j, k;
-    Float sum;
+    this->data.detach();
 
-    FloatArray result(this->rows * other->cols, 0.0);
-
-    for(i = 0; i < this->rows; i++)
-    {
-        for(j = 0; j < other->cols; j++)
-        {
-            sum = 0.0;
+    for(u64 i = 0; i < this->data.size(); i++)
+        this->data[i] *= other.data[i];
 
-            for(k = 0; k < this->cols; k++)
-                sum += this->data[i * this->cols + k] * other->data[k * other->cols + j];
+    return *this;
+}
 
-            result[i * other->cols + j] = sum;
-        }
-    }
+template<typename Float>
+matrix_t& Matrix<Float>::map(std::function<Float(Float)> func)
+{
+    this->data.detach();
 
-    make(this->rows, other->cols, result);
-    check_destroy(other);
+    for(Float& value : this->data)
+        value = func(value);
 
-    return this;
+    return *this;
 }
 
+/* Accumulates `scale * a * bᵀ` into this (rows x cols) matrix, where `a` is (rows x k) and `b` is (cols x k). */
 template<typename Float>
-matrix_t* Matrix<Float>::map(std::function<Float(Float)> func)
+matrix_t& Matrix<Float>::rank_update(Float scale, MatrixView<const Float> a, MatrixView<const Float> b)
 {
-    return make(this->data.map(std::move(func)));
+    assert(a.rows == this->rows && b.rows == this->cols && a.cols == b.cols);
+
+    ::rank_update(scale, a, b, view());
+    return *this;
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::ref()
+matrix_t Matrix<Float>::dot(MatrixView<const Float> other, Accumulation accumulation, const GemmConfig& config) const
 {
-    this->destroy = true;
-    return this;
+    assert(this->cols == other.rows);
+
+    matrix_t result(this->rows, other.cols);
+    gemm(view(), other, result.view(), accumulation, config);
+
+    return result;
 }
 
+/* Computes `thisᵀ * other` without materializing the transpose. */
 template<typename Float>
-matrix_t* Matrix<Float>::clone(bool temporary) const
+matrix_t Matrix<Float>::transpose_dot(MatrixView<const Float> other) const
 {
-    return make(this->rows, this->cols, this->data, temporary);
+    assert(this->rows == other.rows);
+
+    matrix_t result(this->cols, other.cols);
+    transpose_gemm(view(), other, result.view());
+
+    return result;
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::transpose()
+matrix_t Matrix<Float>::transpose() const
 {
-    FloatArray buffer(this->rows * this->cols, 0.0);
+    matrix_t result(this->cols, this->rows);
 
     for(u64 i = 0; i < this->rows; i++)
         for(u64 j = 0; j < this->cols; j++)
-            buffer[j * this->rows + i] = this->data[i * this->cols + j];
+            result.data[j * this->rows + i] = this->data[i * this->cols + j];
 
-    return make(this->cols, this->rows, buffer);
+    return result;
 }
 
 template<typename Float>
-matrix_t* Matrix<Float>::from(const FloatArray& data)
+matrix_t Matrix<Float>::from(const FloatArray& data)
 {
-    return matrix_t::make(data.size(), 1, data, false);
+    return matrix_t(data.size(), 1, data);
 }
 
+/* The largest value below `high`. */
 template<typename Float>
-matrix_t* Matrix<Float>::random(u64 rows, u64 cols)
+static Float below(Float high)
 {
+    if constexpr(std::is_same_v<Float, fdd>)
+        return fdd(high.hi, std::nextafter(high.lo, -INFINITY));
 #ifdef __F128_SUPPORT__
-    if constexpr (std::is_same_v<Float, f128>)
-    {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<long double> dist(0.0, 1.0);
+    else if constexpr(std::is_same_v<Float, f128>)
+        return nextafterq(high, -HUGE_VALQ);
+#endif
+    else
+        return std::nextafter(high, -std::numeric_limits<Float>::infinity());
+}
 
-        FloatArray buffer = FloatArray::with_capacity(rows * cols)
-                .fill([&dist, &gen]BASIC_UNARY(_, static_cast<Float>(dist(gen))));
+/* Fills a matrix with uniform numbers in [low, high) from the Philox stream `(seed, stream)`.
+ * Elements are generated in parallel and the result does not depend on the thread count. */
+template<typename Float>
+matrix_t Matrix<Float>::random(u64 rows, u64 cols, u64 seed, u64 stream, Float low, Float high)
+{
+    matrix_t matrix(rows, cols);
 
-        return matrix_t::make(rows, cols, buffer, false);
-    }
-    else
-    {
-#endif
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<Float> dist(0.0, 1.0);
+    const Philox generator(seed, stream);
+    const Float range = high - low, last = below(high);
+    Float* output = matrix.data.data();
 
-    FloatArray buffer = FloatArray::with_capacity(rows * cols)
-            .fill([&dist, &gen]BASIC_UNARY(_, dist(gen)));
+    /* Draws just under 1 round up to `high` in a narrower `Float` (above 1 - 2^-25 for f32), so they are clamped. */
+    parallel_for(rows * cols, 1 << 16, [&](u64 begin, u64 end)
+    {
+        for(u64 i = begin; i < end; i++)
+        {
+            const Float value = low + range * static_cast<Float>(generator.uniform(i));
+            output[i] = value < high ? value : last;
+        }
+    });
 
-    return matrix_t::make(rows, cols, buffer, false);
-#ifdef __F128_SUPPORT__
-    }
-#endif
+    return matrix;
 }
 
 template<typename Float>
-void Matrix<Float>::display(matrix_t* matrix)
+void Matrix<Float>::display(const matrix_t& matrix)
 {
-    for(u64 row = 0; row < matrix->rows; row++)
+    for(u64 row = 0; row < matrix.rows; row++)
     {
-        for(u64 col = 0; col < matrix->cols; col++)
+        for(u64 col = 0; col < matrix.cols; col++)
         {
-            std::cout << matrix_t::float_to_string(matrix->data[row * matrix->cols + col]);
+            std::cout << matrix_t::float_to_string(matrix.data[row * matrix.cols + col]);
 
-            if(col < matrix->cols - 1)
+            if(col < matrix.cols - 1)
                 std::cout << "\t";
         }
 
@@ -171,13 +203,6 @@ void Matrix<Float>::display(matrix_t* matrix)
     }
 }
 
-template<typename Float>
-void Matrix<Float>::check_destroy(matrix_t* matrix)
-{
-    if(matrix->destroy)
-        delete(matrix);
-}
-
 template<typename Float>
 std::string Matrix<Float>::float_to_string(Float number)
 {
@@ -191,31 +216,10 @@ std::string Matrix<Float>::float_to_string(Float number)
     }
     else
 #endif
-    return std::to_string(number);
-}
-
-template<typename Float>
-matrix_t* Matrix<Float>::make(FloatArray _data)
-{
-    this->data = std::move(_data);
-    return this;
-}
-
-template<typename Float>
-matrix_t* Matrix<Float>::make(u64 _rows, u64 _cols, FloatArray& _data)
-{
-    this->rows = _rows;
-    this->cols = _cols;
-    this->data = _data;
-    return this;
-}
-
-template<typename Float>
-matrix_t* Matrix<Float>::make(u64 _rows, u64 _cols, FloatArray _data, bool _destroy)
-{
-    auto matrix = new matrix_t(_rows, _cols, _data);
-    matrix->destroy = _destroy;
-    return matrix;
+    if constexpr (std::is_same_v<Float, fdd>)
+        return number.to_string(MIN_FDD_PRECISION);
+    else
+        return std::to_string(number);
 }
 
 template<typename Float>
@@ -224,7 +228,7 @@ void Matrix<Float>::assert_float_type()
     if constexpr (!is_float_type<Float>)
     {
         std::cout << "[C++ Matrix]: Matrix<Float> requires Float to be a floating point type.\n";
-        std::cout << "\tSupported float types include: [f32 (float), f64 (double), and f128 (long double || __float128)]" << std::endl;
+        std::cout << "\tSupported float types include: [f32 (float), f64 (double), f128 (long double || __float128), and fdd (double-double)]" << std::endl;
         exit(EXIT_FAILURE);
     }
 }
@@ -1,8 +1,48 @@
+#include <xorai/compress.h>
+#include <xorai/parallel.h>
 #include <xorai/model.h>
+#include <xorai/half.h>
+#include <filesystem>
 #include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <iomanip>
+#include <sstream>
+#include <memory>
+#include <cctype>
+#include <cstring>
 
 #define matrix_t Matrix<Float>
+#define sparse_t SparseMatrix<Float>
+
+/* Stands in for a `d` array of numbers while jsoncpp handles the rest of a model file,
+ * followed by the array's index. jsoncpp writes the control character escaped. */
+#define JSON_MARKER '\x01'
+#define JSON_ESCAPED_MARKER "\"\\u0001"
+
+/* Values formatted, and bytes of text parsed, per task when writing and loading `d` arrays. */
+#define JSON_CHUNK_VALUES 16384
+#define JSON_CHUNK_BYTES 262144
+
+/* Binary model files start with this magic and a format version. Compressed files are version 2,
+ * so that readers which predate compression reject them. */
+#define BINARY_MAGIC "XORAIBIN"
+#define BINARY_VERSION 1
+#define BINARY_COMPRESSED_VERSION 2
+
+/* Flags of a binary model file. */
+#define BINARY_ACTIVATIONS 0x1      // The activations (`d`) of the last sample follow the weights.
+#define BINARY_QUAD 0x2             // F128 values are `__float128` rather than `long double`.
+#define BINARY_COMPRESSED 0x4       // Values are compressed.
+#define BINARY_DELTA 0x8            // Weights and biases are compressed against those of a base model file.
+
+/* One task of a chunked `d` array: values (or bytes) [begin, end) of array `array`. */
+struct JsonChunk
+{
+    u64 array;
+    u64 begin;
+    u64 end;
+};
 
 template<typename Float>
 ModelViewer<Float>::ModelViewer(std::string filename, i8 float_precision)
@@ -20,7 +60,7 @@ ModelViewer<Float>::~ModelViewer()
 }
 
 template<typename Float>
-Model<Float>* ModelViewer<Float>::load()
+Model<Float> ModelViewer<Float>::load(bool activations)
 {
     Json::CharReaderBuilder builder = ModelViewer<Float>::create_reader_builder();
     JSONCPP_STRING errors;
@@ -31,7 +71,16 @@ Model<Float>* ModelViewer<Float>::load()
         std::cout << "[!] File does not exist." << std::endl;
         exit(EXIT_FAILURE);
     }
-    else if(!Json::parseFromStream(builder, this->filestream, &this->root, &errors))
+
+    std::string text(std::istreambuf_iterator<char>(this->filestream), {});
+
+    if(text.compare(0, std::strlen(BINARY_MAGIC), BINARY_MAGIC) == 0)
+        return load_binary(text, activations);
+
+    std::string skeleton = extract(text);
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    if(!reader->parse(skeleton.data(), skeleton.data() + skeleton.size(), &this->root, &errors))
     {
         std::cout << "[C++ ModelViewer]: Failed to parse model file: `" << this->filename << "`\n";
         std::cout << errors << std::endl;
@@ -43,36 +92,187 @@ Model<Float>* ModelViewer<Float>::load()
         exit(EXIT_FAILURE);
     }
 
-    auto model = new Model<Float>;
+    Model<Float> model;
+
+    model.layers  = parse<U64Array>(this->root["l"]);
+    model.data    = activations ? parse<MatrixArray_t>(this->root["d"]) : MatrixArray_t();
+    model.biases  = parse<MatrixArray_t>(this->root["b"]);
+    model.weights = parse<MatrixArray_t>(this->root["w"]);
 
-    model->layers  = parse<U64Array>(this->root["l"]);
-    model->data    = parse<MatrixArray_t>(this->root["d"]);
-    model->biases  = parse<MatrixArray_t>(this->root["b"]);
-    model->weights = parse<MatrixArray_t>(this->root["w"]);
+    for(u64 i = 0; i < this->root["w"].size(); i++)
+    {
+        const Json::Value& matrix = this->root["w"][Json::ArrayIndex(i)];
+
+        if(matrix.isMember("p"))
+            model.sparse.push_back(load_sparse(matrix));
+        else
+            model.sparse.push_back(matrix.isMember("s") ? sparse_t::from(model.weights[i]) : sparse_t());
+    }
+
+    /* Files written before per-layer activations existed use sigmoid everywhere. */
+    if(!this->root.isMember("a"))
+        model.activations.assign(model.weights.size(), Activation::Sigmoid);
+    else
+    {
+        for(const Json::Value& name : this->root["a"])
+            model.activations.push_back(parse_activation(name.asString()));
+
+        if(model.activations.size() != model.weights.size())
+        {
+            std::cout << "[C++ ModelViewer]: Cannot load a malformed model file: `" << this->filename << "`\n";
+            std::cout << "[!] Expected " << model.weights.size() << " activations, found " << model.activations.size() << "." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
 
     return model;
 }
 
 template<typename Float>
-matrix_t* ModelViewer<Float>::load(const Json::Value& matrix)
+matrix_t ModelViewer<Float>::load(const Json::Value& matrix) const
 {
+    if(matrix.isMember("p"))
+        return load_sparse(matrix).dense();
+
     const Json::Value& _rows = matrix["r"];
     const Json::Value& _cols = matrix["c"];
-    const Json::Value& _data = matrix["d"];
 
     u64 rows = _rows.asUInt64();
     u64 cols = _cols.asUInt64();
 
-    cvector<Float> data = cvector<Float>::with_capacity(_data.size());
+    return matrix_t(rows, cols, numbers(matrix["d"]));
+}
+
+template<typename Float>
+sparse_t ModelViewer<Float>::load_sparse(const Json::Value& matrix) const
+{
+    const Json::Value& _offsets = matrix["p"];
+    const Json::Value& _indices = matrix["i"];
+
+    cvector<u64> offsets = cvector<u64>::with_capacity(_offsets.size());
+    cvector<u32> indices = cvector<u32>::with_capacity(_indices.size());
+
+    for(const Json::Value& offset : _offsets)
+        offsets.push_back(offset.asUInt64());
+
+    for(const Json::Value& index : _indices)
+        indices.push_back(index.asUInt());
+
+    return sparse_t(matrix["r"].asUInt64(), matrix["c"].asUInt64(), offsets, indices, numbers(matrix["d"]));
+}
+
+/* The values of a `d` array: either cut out of the file by `extract`, or still in the document. */
+template<typename Float>
+cvector<Float> ModelViewer<Float>::numbers(const Json::Value& array) const
+{
+    if(array.isString() && array.asString()[0] == JSON_MARKER)
+        return this->arrays[std::stoull(array.asString().substr(1))];
+
+    cvector<Float> data = cvector<Float>::with_capacity(array.size());
 
     std::transform(
-        _data.begin(),
-        _data.end(),
+        array.begin(),
+        array.end(),
         std::back_inserter(data),
         []BASIC_UNARY(number, ModelViewer<Float>::string_to_float(number.asString()))
     );
 
-    return new matrix_t(rows, cols, data);
+    return data;
+}
+
+/* Cuts the contents of every `d` array of numbers out of the document and parses them in chunks
+ * on all cores, leaving a marker in their place, so that jsoncpp only builds the model's small skeleton. */
+template<typename Float>
+std::string ModelViewer<Float>::extract(const std::string& text)
+{
+    const char* whitespace = " \t\r\n";
+
+    std::string skeleton;
+    cvector<JsonChunk> chunks;
+    u64 copied = 0, count = 0;
+
+    for(u64 i = 0; i < text.size(); i++)
+    {
+        if(text[i] == '"')
+        {
+            for(i++; i < text.size() && text[i] != '"'; i++)
+                i += text[i] == '\\';
+
+            continue;
+        }
+
+        if(text[i] != '[' || i == 0)
+            continue;
+
+        u64 colon = text.find_last_not_of(whitespace, i - 1);
+        u64 key = colon == std::string::npos || colon == 0 ? std::string::npos : text.find_last_not_of(whitespace, colon - 1);
+
+        if(colon == std::string::npos || text[colon] != ':' || key == std::string::npos || key < 2 || text.compare(key - 2, 3, "\"d\"") != 0)
+            continue;
+
+        /* Only arrays of (quoted) numbers; the activations of a full model are an array of matrices. */
+        u64 first = text.find_first_not_of(whitespace, i + 1);
+        u64 end = text.find(']', i);
+
+        if(first == std::string::npos || end == std::string::npos
+           || !(text[first] == '"' || text[first] == '-' || std::isdigit(static_cast<unsigned char>(text[first]))))
+            continue;
+
+        for(u64 begin = i + 1; begin < end;)
+        {
+            u64 stop = std::min(end, text.find(',', std::min(end, begin + JSON_CHUNK_BYTES)));
+
+            chunks.push_back({count, begin, stop});
+            begin = stop + 1;
+        }
+
+        skeleton.append(text, copied, i - copied);
+        skeleton += JSON_ESCAPED_MARKER + std::to_string(count++) + "\"";
+
+        copied = end + 1;
+        i = end;
+    }
+
+    skeleton.append(text, copied, std::string::npos);
+
+    cvector<cvector<Float>> parsed(chunks.size());
+    std::atomic<bool> malformed(false);
+
+    parallel_for(chunks.size(), 1, [&](u64 from, u64 to)
+    {
+        for(u64 c = from; c < to; c++)
+        {
+            for(u64 p = chunks[c].begin; p < chunks[c].end;)
+            {
+                u64 comma = std::min(chunks[c].end, text.find(',', p));
+                u64 a = text.find_first_not_of(" \t\r\n\"", p);
+                u64 b = text.find_last_not_of(" \t\r\n\"", comma - 1);
+
+                if(a >= comma || b < a)
+                {
+                    malformed.store(true, std::memory_order_relaxed);
+                    break;
+                }
+
+                parsed[c].push_back(ModelViewer<Float>::string_to_float(text.substr(a, b - a + 1)));
+                p = comma + 1;
+            }
+        }
+    });
+
+    if(malformed.load(std::memory_order_relaxed))
+    {
+        std::cout << "[C++ ModelViewer]: Cannot load a malformed model file: `" << this->filename << "`\n";
+        std::cout << "[!] Empty element in a `d` array." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    this->arrays.assign(count, cvector<Float>());
+
+    for(u64 c = 0; c < chunks.size(); c++)
+        this->arrays[chunks[c].array].insert(this->arrays[chunks[c].array].end(), parsed[c].begin(), parsed[c].end());
+
+    return skeleton;
 }
 
 template<typename Float>
@@ -80,12 +280,38 @@ Json::Value ModelViewer<Float>::jsonify(const MatrixArray_t& matrixArray) const
 {
     Json::Value output(Json::arrayValue);
 
-    for(matrix_t* matrix : matrixArray)
+    for(const matrix_t& matrix : matrixArray)
         output.append(jsonify(matrix));
 
     return output;
 }
 
+/* Writes pruned layers in their sparse form and the rest as dense matrices. */
+template<typename Float>
+Json::Value ModelViewer<Float>::jsonify(const MatrixArray_t& matrixArray, const SparseArray_t& sparseArray) const
+{
+    Json::Value output(Json::arrayValue);
+
+    for(u64 i = 0; i < matrixArray.size(); i++)
+    {
+        const bool pruned = i < sparseArray.size() && !sparseArray[i].empty();
+
+        /* Like the matrix products, only layers sparse enough to be smaller in CSR are saved that way.
+         * Denser pruned layers are saved densely and marked (`s`), and their sparse form is rebuilt on load. */
+        if(pruned && sparseArray[i].density() <= SPARSE_DENSITY_THRESHOLD)
+            output.append(jsonify(sparseArray[i]));
+        else
+        {
+            output.append(jsonify(matrixArray[i]));
+
+            if(pruned)
+                output[output.size() - 1]["s"] = true;
+        }
+    }
+
+    return output;
+}
+
 template<typename Float>
 Json::Value ModelViewer<Float>::jsonify(const U64Array& u64Array)
 {
@@ -98,21 +324,58 @@ Json::Value ModelViewer<Float>::jsonify(const U64Array& u64Array)
 }
 
 template<typename Float>
-Json::Value ModelViewer<Float>::jsonify(matrix_t* matrix) const
+Json::Value ModelViewer<Float>::jsonify(const ActivationArray& activations)
+{
+    Json::Value output(Json::arrayValue);
+
+    for(const Activation& activation : activations)
+        output.append(activation_name(activation));
+
+    return output;
+}
+
+template<typename Float>
+Json::Value ModelViewer<Float>::jsonify(const matrix_t& matrix) const
 {
     Json::Value object(Json::objectValue);
-    Json::Value data(Json::arrayValue);
 
-    for(const Float& value : matrix->data)
-        data.append(jsonify(value));
+    object["r"] = Json::UInt64(matrix.rows);
+    object["c"] = Json::UInt64(matrix.cols);
+    object["d"] = defer(matrix.data.data(), matrix.data.size());
 
-    object["r"] = Json::UInt64(matrix->rows);
-    object["c"] = Json::UInt64(matrix->cols);
-    object["d"] = data;
+    return object;
+}
+
+template<typename Float>
+Json::Value ModelViewer<Float>::jsonify(const sparse_t& matrix) const
+{
+    Json::Value object(Json::objectValue);
+    Json::Value offsets(Json::arrayValue);
+    Json::Value indices(Json::arrayValue);
+
+    for(const u64& offset : matrix.offsets)
+        offsets.append(Json::UInt64(offset));
+
+    for(const u32& index : matrix.indices)
+        indices.append(Json::UInt(index));
+
+    object["r"] = Json::UInt64(matrix.rows);
+    object["c"] = Json::UInt64(matrix.cols);
+    object["p"] = offsets;
+    object["i"] = indices;
+    object["d"] = defer(matrix.values.data(), matrix.values.size());
 
     return object;
 }
 
+/* Leaves a marker in place of a `d` array, which `write` formats in parallel and splices into the output. */
+template<typename Float>
+Json::Value ModelViewer<Float>::defer(const Float* values, u64 count) const
+{
+    this->pending.emplace_back(values, count);
+    return Json::Value(std::string(1, JSON_MARKER) + std::to_string(this->pending.size() - 1));
+}
+
 template<typename Float>
 std::string ModelViewer<Float>::jsonify(Float number) const {
 #ifdef __F128_SUPPORT__
@@ -124,9 +387,14 @@ std::string ModelViewer<Float>::jsonify(Float number) const {
     else
     {
 #endif
-    std::stringstream s;
-    (s << std::fixed << std::setprecision(static_cast<int>(this->float_precision)) << number);
-    return s.str();
+    if constexpr (std::is_same_v<Float, fdd>)
+        return number.to_string(this->float_precision);
+    else
+    {
+        std::stringstream s;
+        (s << std::fixed << std::setprecision(static_cast<int>(this->float_precision)) << number);
+        return s.str();
+    }
 #ifdef __F128_SUPPORT__
     }
 #endif
@@ -134,15 +402,15 @@ std::string ModelViewer<Float>::jsonify(Float number) const {
 
 template<typename Float>
 template<typename T>
-T ModelViewer<Float>::parse(const Json::Value& jsonValue)
+T ModelViewer<Float>::parse(const Json::Value& jsonValue) const
 {
-    using ModifierReturnType = std::conditional_t<std::is_same_v<T, MatrixArray_t>, matrix_t*, Json::UInt64>;
+    using ModifierReturnType = std::conditional_t<std::is_same_v<T, MatrixArray_t>, matrix_t, Json::UInt64>;
     std::function<ModifierReturnType(const Json::Value&)> modifier;
 
     if constexpr(std::is_same_v<T, U64Array>)
         modifier = []BASIC_UNARY(json_value, json_value.asUInt64());
     else if constexpr(std::is_same_v<T, MatrixArray_t>)
-        modifier = []BASIC_UNARY(json_value, ModelViewer<Float>::load(json_value));
+        modifier = [this]BASIC_UNARY(json_value, load(json_value));
     else
     {
         std::cout << "[C++ ModelViewer]: Unable to parse `Json::Value` with the given template type.\n";
@@ -155,13 +423,527 @@ T ModelViewer<Float>::parse(const Json::Value& jsonValue)
     return output;
 }
 
+/* Writes the document with jsoncpp, except for the deferred `d` arrays, which are formatted in chunks
+ * on all cores and spliced in where their markers are. The bytes are the same as jsoncpp's own. */
 template<typename Float>
 void ModelViewer<Float>::write(const Json::Value& json)
 {
+    std::ostringstream document;
+    writer->write(json, &document);
+
+    const std::string skeleton = document.str();
+    const u64 marker = std::string(JSON_ESCAPED_MARKER).size();
+
+    cvector<JsonChunk> chunks;
+    cvector<u64> first_chunk;
+
+    for(u64 a = 0; a < this->pending.size(); a++)
+    {
+        first_chunk.push_back(chunks.size());
+
+        for(u64 begin = 0; begin < this->pending[a].second; begin += JSON_CHUNK_VALUES)
+            chunks.push_back({a, begin, std::min(this->pending[a].second, begin + JSON_CHUNK_VALUES)});
+    }
+
+    first_chunk.push_back(chunks.size());
+
+    cvector<std::string> formatted(chunks.size());
+
+    parallel_for(chunks.size(), 1, [&](u64 from, u64 to)
+    {
+        for(u64 c = from; c < to; c++)
+        {
+            const Float* values = this->pending[chunks[c].array].first;
+
+            for(u64 k = chunks[c].begin; k < chunks[c].end; k++)
+            {
+                if(k > chunks[c].begin)
+                    formatted[c] += ',';
+
+                formatted[c] += '"';
+                formatted[c] += jsonify(values[k]);
+                formatted[c] += '"';
+            }
+        }
+    });
+
+    /* Truncate, so that a smaller model never leaves the tail of a previous one behind. */
+    this->filestream.close();
+    this->filestream = std::fstream(this->filename, std::ios::out | std::ios::trunc);
+
+    u64 copied = 0;
+
+    for(u64 at = skeleton.find(JSON_ESCAPED_MARKER); at != std::string::npos; at = skeleton.find(JSON_ESCAPED_MARKER, copied))
+    {
+        u64 close = skeleton.find('"', at + 1);
+        u64 array = std::stoull(skeleton.substr(at + marker, close - at - marker));
+
+        this->filestream.write(skeleton.data() + copied, static_cast<std::streamsize>(at - copied));
+        this->filestream << '[';
+
+        for(u64 c = first_chunk[array]; c < first_chunk[array + 1]; c++)
+            this->filestream << (c > first_chunk[array] ? "," : "") << formatted[c];
+
+        this->filestream << ']';
+        copied = close + 1;
+    }
+
+    this->filestream.write(skeleton.data() + copied, static_cast<std::streamsize>(skeleton.size() - copied));
+    this->pending.clear();
+}
+
+/* The storage format of a network's own float type. */
+template<typename Float>
+static constexpr Storage native_storage()
+{
+    if constexpr (std::is_same_v<Float, f32>)
+        return Storage::F32;
+    else if constexpr (std::is_same_v<Float, f64>)
+        return Storage::F64;
+    else if constexpr (std::is_same_v<Float, fdd>)
+        return Storage::FDD;
+    else
+        return Storage::F128;
+}
+
+static u64 storage_size(Storage storage)
+{
+    switch(storage)
+    {
+        case Storage::F16:
+        case Storage::BF16: return 2;
+        case Storage::F32: return 4;
+        case Storage::F64: return 8;
+        default: return 16;
+    }
+}
+
+/* Appends `count` values to `out` in the format of `storage`. */
+template<typename Float>
+static void encode(Storage storage, const Float* values, u64 count, std::string& out)
+{
+    const u64 width = storage_size(storage);
+    const u64 at = out.size();
+
+    out.resize(at + count * width);
+    char* target = out.data() + at;
+
+    for(u64 i = 0; i < count; i++, target += width)
+    {
+        switch(storage)
+        {
+            case Storage::F16: { f16 value(static_cast<f32>(values[i])); std::memcpy(target, &value, width); break; }
+            case Storage::BF16: { bf16 value(static_cast<f32>(values[i])); std::memcpy(target, &value, width); break; }
+            case Storage::F32: { f32 value = static_cast<f32>(values[i]); std::memcpy(target, &value, width); break; }
+            case Storage::F64: { f64 value = static_cast<f64>(values[i]); std::memcpy(target, &value, width); break; }
+            default: std::memcpy(target, values + i, width);
+        }
+    }
+}
+
+/* Reads `count` values in the format of `storage`. */
+template<typename Float>
+static void decode(Storage storage, const char* source, Float* values, u64 count)
+{
+    const u64 width = storage_size(storage);
+
+    for(u64 i = 0; i < count; i++, source += width)
+    {
+        switch(storage)
+        {
+            case Storage::F16: { f16 value; std::memcpy(&value, source, width); values[i] = Float(static_cast<f64>(static_cast<f32>(value))); break; }
+            case Storage::BF16: { bf16 value; std::memcpy(&value, source, width); values[i] = Float(static_cast<f64>(static_cast<f32>(value))); break; }
+            case Storage::F32: { f32 value; std::memcpy(&value, source, width); values[i] = Float(static_cast<f64>(value)); break; }
+            case Storage::F64: { f64 value; std::memcpy(&value, source, width); values[i] = Float(value); break; }
+            default: std::memcpy(values + i, source, width);
+        }
+    }
+}
+
+/* The weights and biases of the model file `path`, loaded as `Carrier` values and encoded in the format of `storage`.
+ * Loading in a type that holds the format exactly gives the same bytes whatever the type of the network. */
+template<typename Carrier>
+static std::string encoded_parameters(const std::string& path, Storage storage, const U64Array& layers)
+{
+    ModelViewer<Carrier> viewer(path);
+    Model<Carrier> model = viewer.load(false);
+
+    if(model.layers != layers)
+    {
+        std::cout << "[C++ ModelViewer]: The base model `" << path << "` does not have the layers of its delta." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string out;
+
+    for(u64 i = 0; i < model.weights.size(); i++)
+    {
+        encode(storage, model.weights[i].data.data(), model.weights[i].data.size(), out);
+        encode(storage, model.biases[i].data.data(), model.biases[i].data.size(), out);
+    }
+
+    return out;
+}
+
+template<typename Float>
+static std::string base_parameters(const std::string& path, Storage storage, const U64Array& layers)
+{
+    switch(storage)
+    {
+        case Storage::F16:
+        case Storage::BF16:
+        case Storage::F32: return encoded_parameters<f32>(path, storage, layers);
+        case Storage::F64: return encoded_parameters<f64>(path, storage, layers);
+        default: return encoded_parameters<Float>(path, storage, layers);
+    }
+}
+
+/* FNV-1a over 8-byte words, to recognize the base of a delta. */
+static u64 checksum(const std::string& bytes)
+{
+    u64 hash = 0xcbf29ce484222325, i = 0;
+
+    for(; i + sizeof(u64) <= bytes.size(); i += sizeof(u64))
+    {
+        u64 word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3;
+    }
+
+    for(; i < bytes.size(); i++)
+        hash = (hash ^ static_cast<u8>(bytes[i])) * 0x100000001b3;
+
+    return hash;
+}
+
+/* Writes `model` as a binary model file:
+ *
+ *   "XORAIBIN" | u32 version | u8 storage | u8 flags | u16 0 | u64 count | count x u64 layers
+ *   | per weight layer: u8 activation, u8 pruned | zeros up to a multiple of 8 bytes
+ *   | if flags & BINARY_DELTA: u64 length, the base's path | u64 checksum of its values | zeros up to a multiple of 8 bytes
+ *   | per weight layer: weights (row-major), biases
+ *   | if flags & BINARY_ACTIVATIONS: u64 matrices | per matrix: u64 rows, u64 cols, values
+ *
+ * Numbers use the host byte order. Pruned layers are stored densely and their sparse form is rebuilt
+ * from the nonzero weights on load. Compressed files store the weights and biases of all layers as one
+ * compressed array (see `compress_values`) and the activations as another, after all their shapes.
+ * A delta names its base relative to its own directory, and predicts the weights and biases from the base's. */
+template<typename Float>
+void ModelViewer<Float>::write(const Model<Float>& model, Storage storage, Encoding encoding, const std::string& base)
+{
+    if(storage == Storage::Native)
+        storage = native_storage<Float>();
+
+    if((storage == Storage::F128 || storage == Storage::FDD) && storage != native_storage<Float>())
+    {
+        std::cout << "[C++ ModelViewer]: Only networks of the same float type can store F128 or FDD values." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string out(BINARY_MAGIC);
+    auto put = [&out](const auto& value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    const bool compressed = encoding == Encoding::Compressed || !base.empty();
+    u8 flags = model.data.empty() ? 0 : BINARY_ACTIVATIONS;
+
+#ifdef __F128_SUPPORT__
+    if(storage == Storage::F128)
+        flags |= BINARY_QUAD;
+#endif
+
+    if(compressed)
+        flags |= BINARY_COMPRESSED | (base.empty() ? 0 : BINARY_DELTA);
+
+    put(static_cast<u32>(compressed ? BINARY_COMPRESSED_VERSION : BINARY_VERSION));
+    put(static_cast<u8>(storage));
+    put(flags);
+    put(static_cast<u16>(0));
+    put(static_cast<u64>(model.layers.size()));
+
+    for(u64 layer : model.layers)
+        put(layer);
+
+    for(u64 i = 0; i < model.weights.size(); i++)
+    {
+        put(static_cast<u8>(model.activations[i]));
+        put(static_cast<u8>(i < model.sparse.size() && !model.sparse[i].empty()));
+    }
+
+    out.resize((out.size() + 7) / 8 * 8, '\0');
+
+    const u64 width = storage_size(storage);
+    std::string reference;
+
+    if(flags & BINARY_DELTA)
+    {
+        namespace fs = std::filesystem;
+
+        if(fs::absolute(base).lexically_normal() == fs::absolute(this->filename).lexically_normal())
+        {
+            std::cout << "[C++ ModelViewer]: A delta cannot replace its own base: `" << this->filename << "`" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        const std::string path = fs::proximate(fs::absolute(base), fs::absolute(this->filename).parent_path()).generic_string();
+        reference = base_parameters<Float>(base, storage, model.layers);
+
+        put(static_cast<u64>(path.size()));
+        out += path;
+        put(checksum(reference));
+        out.resize((out.size() + 7) / 8 * 8, '\0');
+    }
+
+    std::string parameters;
+
+    for(u64 i = 0; i < model.weights.size(); i++)
+    {
+        encode(storage, model.weights[i].data.data(), model.weights[i].data.size(), compressed ? parameters : out);
+        encode(storage, model.biases[i].data.data(), model.biases[i].data.size(), compressed ? parameters : out);
+    }
+
+    if(compressed)
+        compress_values(parameters.data(), reference.empty() ? nullptr : reference.data(), parameters.size() / width, width, out);
+
+    if(flags & BINARY_ACTIVATIONS)
+    {
+        std::string activations;
+        put(static_cast<u64>(model.data.size()));
+
+        for(const matrix_t& matrix : model.data)
+        {
+            put(matrix.rows);
+            put(matrix.cols);
+            encode(storage, matrix.data.data(), matrix.data.size(), compressed ? activations : out);
+        }
+
+        if(compressed)
+            compress_values(activations.data(), nullptr, activations.size() / width, width, out);
+    }
+
+    this->filestream.close();
+    this->filestream = std::fstream(this->filename, std::ios::out | std::ios::trunc | std::ios::binary);
+    this->filestream.write(out.data(), static_cast<std::streamsize>(out.size()));
+
     if(!this->filestream)
-        this->filestream = create_file_stream();
+    {
+        std::cout << "[C++ ModelViewer]: Failed to write model file: `" << this->filename << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Reads a binary model file (see `write`), converting its values to `Float`. */
+template<typename Float>
+Model<Float> ModelViewer<Float>::load_binary(const std::string& text, bool activations)
+{
+    u64 at = std::strlen(BINARY_MAGIC);
+
+    auto malformed = [this]()
+    {
+        std::cout << "[C++ ModelViewer]: Cannot load a malformed model file: `" << this->filename << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    };
 
-    writer->write(json, &this->filestream);
+    auto take = [&](void* target, u64 size)
+    {
+        if(size > text.size() - at)
+            malformed();
+
+        std::memcpy(target, text.data() + at, size);
+        at += size;
+    };
+
+    u32 version = 0;
+    u8 code = 0, flags = 0;
+    u16 reserved = 0;
+    u64 count = 0;
+
+    take(&version, sizeof(version));
+    take(&code, sizeof(code));
+    take(&flags, sizeof(flags));
+    take(&reserved, sizeof(reserved));
+    take(&count, sizeof(count));
+
+    const auto storage = static_cast<Storage>(code);
+
+    if(version != (flags & BINARY_COMPRESSED ? BINARY_COMPRESSED_VERSION : BINARY_VERSION))
+    {
+        std::cout << "[C++ ModelViewer]: Unsupported binary model version " << version << ": `" << this->filename << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if(code > static_cast<u8>(Storage::FDD) || count < 2 || count > (text.size() - at) / sizeof(u64))
+        malformed();
+
+    bool quad = false;
+
+#ifdef __F128_SUPPORT__
+    quad = true;
+#endif
+
+    if((storage == Storage::F128 || storage == Storage::FDD)
+        && (storage != native_storage<Float>() || (storage == Storage::F128 && quad != bool(flags & BINARY_QUAD))))
+    {
+        std::cout << "[C++ ModelViewer]: `" << this->filename << "` stores " << (storage == Storage::FDD ? "fdd" : "f128")
+                  << " values, which only a network of that type (and build) can load." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Model<Float> model;
+    cvector<bool> pruned;
+
+    model.layers.resize(count);
+
+    for(u64& layer : model.layers)
+        take(&layer, sizeof(layer));
+
+    for(u64 i = 0; i + 1 < count; i++)
+    {
+        u8 activation = 0, sparse = 0;
+
+        take(&activation, sizeof(activation));
+        take(&sparse, sizeof(sparse));
+
+        if(activation > static_cast<u8>(Activation::Identity))
+            malformed();
+
+        model.activations.push_back(static_cast<Activation>(activation));
+        pruned.push_back(sparse != 0);
+    }
+
+    at = std::min<u64>((at + 7) / 8 * 8, text.size());
+
+    const u64 width = storage_size(storage);
+    std::string reference;
+
+    if(flags & BINARY_DELTA)
+    {
+        u64 length = 0, expected = 0;
+        take(&length, sizeof(length));
+
+        if(length > text.size() - at)
+            malformed();
+
+        /* The base is named relative to the directory of the delta. */
+        const std::string path = (std::filesystem::path(this->filename).parent_path() / text.substr(at, length)).string();
+        at += length;
+        take(&expected, sizeof(expected));
+        at = std::min<u64>((at + 7) / 8 * 8, text.size());
+
+        reference = base_parameters<Float>(path, storage, model.layers);
+
+        if(checksum(reference) != expected)
+        {
+            std::cout << "[C++ ModelViewer]: The base model `" << path << "` of `" << this->filename
+                      << "` changed since the delta was written." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Plain values are read in place, compressed ones after expanding them into the layout of a plain file. */
+    const bool compressed = flags & BINARY_COMPRESSED;
+    std::string expanded;
+    const char* source = text.data();
+    u64 cursor = at, end = text.size();
+
+    auto expand = [&](u64 values, const char* base)
+    {
+        const char* next = text.data() + at;
+
+        if(!decompress_values(next, text.size() - at, base, expanded, values, width))
+            malformed();
+
+        at = static_cast<u64>(next - text.data());
+        source = expanded.data();
+        cursor = 0;
+        end = expanded.size();
+    };
+
+    auto values = [&](u64 rows, u64 cols)
+    {
+        if(cols && rows > (end - cursor) / width / cols)
+            malformed();
+
+        matrix_t matrix(rows, cols);
+        decode(storage, source + cursor, matrix.data.data(), rows * cols);
+
+        cursor += rows * cols * width;
+        return matrix;
+    };
+
+    if(compressed)
+    {
+        u64 parameters = 0;
+
+        /* The shapes are untrusted until the payload is checked against their total. */
+        for(u64 i = 0; i + 1 < count; i++)
+        {
+            const u64 rows = model.layers[i + 1], cols = model.layers[i] + 1;
+
+            if(cols == 0 || rows > (~u64(0) - parameters) / cols)
+                malformed();
+
+            parameters += rows * cols;
+        }
+
+        expand(parameters, reference.empty() ? nullptr : reference.data());
+    }
+
+    for(u64 i = 0; i + 1 < count; i++)
+    {
+        model.weights.push_back(values(model.layers[i + 1], model.layers[i]));
+        model.biases.push_back(values(model.layers[i + 1], 1));
+        model.sparse.push_back(pruned[i] ? sparse_t::from(model.weights.back()) : sparse_t());
+    }
+
+    if(!(flags & BINARY_ACTIVATIONS))
+        return model;
+
+    if(!compressed)
+        at = cursor;
+
+    u64 matrices = 0, total = 0;
+    take(&matrices, sizeof(matrices));
+
+    if(matrices > (text.size() - at) / (2 * sizeof(u64)))
+        malformed();
+
+    cvector<std::pair<u64, u64>> shapes(matrices);
+
+    for(auto& [rows, cols] : shapes)
+    {
+        take(&rows, sizeof(rows));
+        take(&cols, sizeof(cols));
+
+        if(compressed)
+        {
+            if(cols && rows > (~u64(0) - total) / width / cols)
+                malformed();
+
+            total += rows * cols;
+        }
+        else
+        {
+            if(cols && rows > (text.size() - at) / width / cols)
+                malformed();
+
+            cursor = at;
+
+            if(activations)
+                model.data.push_back(values(rows, cols));
+
+            at += rows * cols * width;
+        }
+    }
+
+    if(compressed && activations)
+    {
+        expand(total, nullptr);
+
+        for(const auto& [rows, cols] : shapes)
+            model.data.push_back(values(rows, cols));
+    }
+
+    return model;
 }
 
 template<typename Float>
@@ -176,11 +958,14 @@ bool ModelViewer<Float>::check_root_members()
             case 'd': flags[1] = true; break;
             case 'b': flags[2] = true; break;
             case 'w': flags[3] = true; break;
+            case 'a': break;
             default: return false;
         }
     }
 
-    return flags[0] && flags[1] && flags[2] && flags[3];
+    /* The activations (`d`) are optional, inference-only models omit them.
+     * So are the activation functions (`a`), which older files lack. */
+    return flags[0] && flags[2] && flags[3];
 }
 
 template<typename Float>
@@ -239,6 +1024,8 @@ Float ModelViewer<Float>::string_to_float(const std::string& number)
 #else
         return std::stold(number);
 #endif
+    else if constexpr (std::is_same_v<Float, fdd>)
+        return fdd::parse(number);
 
     std::cout << "[C++ ModelViewer]: Failed to convert float to " << typeid(Float).name() << std::endl;
     exit(EXIT_FAILURE);
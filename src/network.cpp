@@ -1,11 +1,16 @@
 #include <xorai/activation.h>
 #include <xorai/network.h>
+#include <algorithm>
+#include <unistd.h>
 #include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
 
 #define matrix_t Matrix<Float>
 
 template<typename Float>
-Network<Float>::Network(const U64Array& layers, Float learning_rate)
+Network<Float>::Network(const U64Array& layers, Float learning_rate, Initializer initializer, u64 seed)
 {
     assert_float_type();
 
@@ -15,154 +20,559 @@ Network<Float>::Network(const U64Array& layers, Float learning_rate)
 
     for(u64 i = 0; i < layers.size() - 1; i++)
     {
-        this->weights.push_back(matrix_t::random(layers[i + 1], layers[i]));
-        this->biases.push_back(matrix_t::random(layers[i + 1], 1));
+        Float low = 0.0, high = 1.0;
+        f64 fan_in = static_cast<f64>(layers[i]), fan_out = static_cast<f64>(layers[i + 1]);
+
+        if(initializer == Initializer::Xavier)
+            high = static_cast<Float>(std::sqrt(6.0 / (fan_in + fan_out)));
+        else if(initializer == Initializer::He)
+            high = static_cast<Float>(std::sqrt(6.0 / fan_in));
+
+        if(initializer != Initializer::Uniform)
+            low = -high;
+
+        /* Every matrix draws from its own Philox stream, so the weights only depend on the seed. */
+        this->weights.push_back(matrix_t::random(layers[i + 1], layers[i], seed, 2 * i, low, high));
+        this->biases.push_back(initializer == Initializer::Uniform
+                ? matrix_t::random(layers[i + 1], 1, seed, 2 * i + 1)
+                : matrix_t(layers[i + 1], 1));
     }
 
     this->layers = layers;
+    this->activations.assign(layers.size() - 1, Activation::Sigmoid);
     this->learning_rate = learning_rate;
+    this->accumulation = Accumulation::Naive;
+    this->memory_budget = 0;
+    this->seed = seed;
 }
 
 template<typename Float>
 Network<Float>::Network(std::string filename, Float learning_rate)
+    : Network(ModelViewer<Float>(std::move(filename)).load(), learning_rate)
 {
-    assert_float_type();
+}
 
-    ModelViewer<Float> viewer(std::move(filename));
-    Model<Float>* model = viewer.load();
+/* Takes over the layers, parameters and activations of `model` as they are, without initializing anything. */
+template<typename Float>
+Network<Float>::Network(Model<Float> model, Float learning_rate)
+{
+    assert_float_type();
 
-    this->data = model->data;
-    this->biases = model->biases;
-    this->weights = model->weights;
+    this->data = std::move(model.data);
+    this->biases = std::move(model.biases);
+    this->weights = std::move(model.weights);
+    this->sparse = std::move(model.sparse);
+    this->activations = std::move(model.activations);
 
-    this->layers = model->layers;
+    this->layers = std::move(model.layers);
     this->learning_rate = learning_rate;
+    this->accumulation = Accumulation::Naive;
+    this->memory_budget = 0;
+    this->seed = 0;
+}
+
+template<typename Float>
+const matrix_t& Network<Float>::feed_forward(const matrix_t& inputs)
+{
+    assert(this->layers[0] == inputs.data.size());
+
+    this->data.resize(this->layers.size());
+    this->data[0] = inputs;
+
+    for(u64 i = 0; i < this->layers.size() - 1; i++)
+        this->data[i + 1] = forward_layer(i, this->data[i]);
 
-    delete(model);
+    return this->data.back();
 }
 
 template<typename Float>
-Network<Float>::~Network()
+void Network<Float>::back_propagate(const matrix_t& outputs, const matrix_t& targets)
 {
-    auto d = BASIC_UNARY_DELETE;
+    matrix_t errors = targets - outputs;
 
-    this->data.map(d);
-    this->biases.map(d);
-    this->weights.map(d);
+    for(u64 i = this->layers.size() - 1; i--;)
+        errors = backward_layer(i, this->data[i], i + 2 == this->layers.size() ? outputs : this->data[i + 1], errors);
 }
 
 template<typename Float>
-matrix_t* Network<Float>::feed_forward(matrix_t* inputs)
+void Network<Float>::train(Dataset<Float>& inputs, Dataset<Float>& targets, u64 epochs)
 {
-    assert(this->layers[0] == inputs->data.size());
+    u64 i, j;
 
-    this->data.map_if(!this->data.empty(), BASIC_UNARY_DELETE);
+    for(i = 1; i < epochs + 1; i++)
+    {
+#if defined(DEBUG) && !defined(NO_DEBUG)
+        if((epochs < 100) || (i % (epochs / 100) == 0))
+            std::cout << "Epoch " << i << " of " << epochs << "\n";
+#endif
+        for(j = 0; j < inputs.size(); j++)
+            back_propagate(feed_forward(matrix_t::from(inputs[j])), matrix_t::from(targets[j]));
+    }
+}
 
-    matrix_t* current = inputs;
-    this->data = {current->clone()};
+/* Applies one gradient step for a single sample. Unlike `train`, the sample's activations are not kept,
+ * so a stream of samples costs the same per sample however long it runs. */
+template<typename Float>
+void Network<Float>::partial_fit(const cvector<Float>& input, const cvector<Float>& target)
+{
+    partial_fit(matrix_t::from(input), matrix_t::from(target));
+}
 
-    for(u64 i = 0; i < this->layers.size() - 1; i++)
+/* Applies one gradient step for a mini-batch (one sample per column), summing the per-sample updates.
+ * `predict` calls on other threads wait for the step to finish and never see a half-updated network. */
+template<typename Float>
+void Network<Float>::partial_fit(MatrixView<const Float> inputs, MatrixView<const Float> targets)
+{
+    std::unique_lock<SharedMutex> lock(this->guard);
+    fit_batch(inputs, targets);
+}
+
+/* The gradient step of `partial_fit`, without locking. Only the activations chosen by `checkpoints` are kept
+ * by the forward pass; the others are recomputed from the nearest checkpoint below them when the backward
+ * pass reaches them, which gives the same result. `observe(layer, updated)`, when set, is called right
+ * before (false) and after (true) each layer's update. */
+template<typename Float>
+void Network<Float>::fit_batch(MatrixView<const Float> inputs, MatrixView<const Float> targets,
+                               const std::function<void(u64, bool)>& observe)
+{
+    assert(this->layers.front() == inputs.rows && this->layers.back() == targets.rows);
+    assert(inputs.cols == targets.cols);
+
+    const u64 depth = this->layers.size() - 1;
+    const cvector<bool> stored = checkpoints(inputs.cols);
+    MatrixArray<Float> outputs(depth);
+
+    auto input = [&](u64 layer) { return layer ? MatrixView<const Float>(outputs[layer - 1].view()) : inputs; };
+
+    /* Recomputes the output of `layer` and the missing ones below it. */
+    auto restore = [&](u64 layer)
+    {
+        u64 first = layer;
+
+        while(first > 0 && outputs[first - 1].data.size() == 0)
+            first--;
+
+        for(u64 i = first; i <= layer; i++)
+            outputs[i] = forward_layer(i, input(i));
+    };
+
+    for(u64 i = 0; i < depth; i++)
     {
-        current = this->weights[i]->clone()
-                ->dot(current)
-                ->add(this->biases[i])
-                ->map(sigmoid<Float>);
+        outputs[i] = forward_layer(i, input(i));
 
-        this->data.push_back(current);
+        if(i > 0 && !stored[i - 1])
+            outputs[i - 1] = matrix_t();
     }
 
-    return current;
+    matrix_t errors(targets.rows, targets.cols);
+
+    for(u64 r = 0; r < targets.rows; r++)
+        for(u64 c = 0; c < targets.cols; c++)
+            errors.data[r * targets.cols + c] = targets(r, c) - outputs.back().data[r * targets.cols + c];
+
+    if(!stored.back())
+        outputs.back() = matrix_t();
+
+    for(u64 i = depth; i--;)
+    {
+        if(outputs[i].data.size() == 0)
+            restore(i);
+        if(i > 0 && outputs[i - 1].data.size() == 0)
+            restore(i - 1);
+
+        if(observe)
+            observe(i, false);
+
+        errors = backward_layer(i, input(i), outputs[i], errors);
+        outputs[i] = matrix_t();
+
+        if(observe)
+            observe(i, true);
+    }
 }
 
+/* Picks the layers whose outputs a mini-batch of `columns` samples keeps through its forward pass.
+ * A plan keeps a layer whenever the run of dropped layers below it would outgrow a cap; its peak is
+ * the kept outputs plus the longest run, which is recomputed at once. Among the caps given by runs of
+ * layers, the plan that fits `memory_budget` and keeps the most bytes (recomputes the least) wins, or,
+ * if none fits, the one with the smallest peak. Without a budget, every output is kept. */
 template<typename Float>
-void Network<Float>::back_propagate(matrix_t* inputs, matrix_t* targets)
+cvector<bool> Network<Float>::checkpoints(u64 columns) const
 {
-    matrix_t* errors = targets->clone()->sub(inputs);
-    matrix_t* gradients = inputs->clone()->map(derivative<Float>);
+    const u64 depth = this->layers.size() - 1;
+    cvector<bool> best(depth, true);
 
-    auto scale = [this]BASIC_UNARY(x, x * this->learning_rate);
+    if(this->memory_budget == 0)
+        return best;
 
-    for(u64 i = this->layers.size() - 1; i--;)
+    cvector<u64> sizes(depth), caps = {0};
+
+    for(u64 i = 0; i < depth; i++)
+        sizes[i] = this->layers[i + 1] * columns * sizeof(Float);
+
+    for(u64 i = 0; i < depth; i++)
+        for(u64 j = i, run = 0; j < depth; j++)
+            caps.push_back(run += sizes[j]);
+
+    std::sort(caps.begin(), caps.end());
+    caps.erase(std::unique(caps.begin(), caps.end()), caps.end());
+
+    u64 best_kept = 0, best_peak = UINT64_MAX;
+    bool best_fits = false;
+
+    for(u64 cap : caps)
     {
-        gradients->mul(errors)->map(scale);
+        cvector<bool> plan(depth, false);
+        u64 kept = 0, run = 0, longest = 0;
+
+        for(u64 i = 0; i < depth; i++)
+        {
+            if(run + sizes[i] > cap)
+            {
+                plan[i] = true;
+                kept += sizes[i];
+                run = 0;
+            }
+            else
+                longest = std::max(longest, run += sizes[i]);
+        }
 
-        this->weights[i]->add(gradients->clone(true)->dot(this->data[i]->clone(true)->transpose()));
-        this->biases[i]->add(gradients->ref());
+        const u64 peak = kept + longest;
+        const bool fits = peak <= this->memory_budget;
 
-        errors = this->weights[i]->clone()->transpose()->dot(errors->ref());
-        gradients = this->data[i]->clone()->map(derivative<Float>);
+        if(fits ? !best_fits || kept > best_kept : !best_fits && peak < best_peak)
+        {
+            best = std::move(plan);
+            best_kept = kept;
+            best_peak = peak;
+            best_fits = fits;
+        }
     }
 
-    delete(errors);
-    delete(gradients);
+    return best;
 }
 
+/* Trains on records read from `fd` (a file, pipe or socket) until end of file, `batch` records per step.
+ * A record is the input values followed by the target values, as native-endian f64. Only one batch of
+ * records is buffered at a time. Returns the number of samples used. */
 template<typename Float>
-void Network<Float>::train(Dataset<Float>& inputs, Dataset<Float>& targets, u64 epochs)
+u64 Network<Float>::partial_fit(i32 fd, u64 batch)
 {
-    matrix_t *input, *target, *output;
-    u64 i, j;
+    const u64 inputs = this->layers.front(), outputs = this->layers.back();
+    const u64 record = (inputs + outputs) * sizeof(f64);
 
-    for(i = 1; i < epochs + 1; i++)
+    batch = std::max<u64>(batch, 1);
+
+    cvector<u8> buffer(record * batch);
+    cvector<f64> values(inputs + outputs);
+    matrix_t x(inputs, batch), y(outputs, batch);
+    u64 filled = 0, count = 0;
+    bool open = true;
+
+    while(open)
     {
-#if defined(DEBUG) && !defined(NO_DEBUG)
-        if((epochs < 100) || (i % (epochs / 100) == 0))
-            std::cout << "Epoch " << i << " of " << epochs << "\n";
-#endif
-        for(j = 0; j < inputs.size(); j++)
+        ssize_t received = ::read(fd, buffer.data() + filled, buffer.size() - filled);
+
+        if(received < 0 && errno == EINTR)
+            continue;
+
+        if(received < 0)
+        {
+            std::cout << "[C++ Network]: Failed to read training records: " << std::strerror(errno) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        open = received > 0;
+        filled += static_cast<u64>(std::max<ssize_t>(received, 0));
+
+        if(filled < buffer.size() && (open || filled < record))
+            continue;
+
+        const u64 samples = filled / record;
+
+        for(u64 j = 0; j < samples; j++)
         {
-            input = matrix_t::from(inputs[j].clone());
-            target = matrix_t::from(targets[j].clone());
-            output = feed_forward(input);
+            std::memcpy(values.data(), buffer.data() + j * record, record);
 
-            back_propagate(output, target);
+            for(u64 r = 0; r < inputs; r++)
+                x.data[r * batch + j] = static_cast<Float>(values[r]);
 
-            delete(input);
-            delete(target);
+            for(u64 r = 0; r < outputs; r++)
+                y.data[r * batch + j] = static_cast<Float>(values[inputs + r]);
         }
+
+        /* A short last batch trains on the first columns in place. */
+        partial_fit(x.view().col_range(0, samples), y.view().col_range(0, samples));
+
+        count += samples;
+        filled -= samples * record;
     }
+
+    if(filled > 0)
+        std::cout << "[C++ Network]: Ignoring " << filled << " trailing bytes of an incomplete record" << std::endl;
+
+    return count;
 }
 
+/* Runs a forward pass without touching the network's stored activations.
+ * Each column of `inputs` is one sample, so a whole batch runs through one GEMM per layer. */
 template<typename Float>
-matrix_t* Network<Float>::test(Float a, Float b)
+matrix_t Network<Float>::predict(matrix_t inputs) const
 {
-    /* Save the network's current data state */
-    MatrixArray<Float> netdata = this->data.clone();
-    this->data = {};
+    assert(this->layers[0] == inputs.rows);
+
+    std::shared_lock<SharedMutex> lock(this->guard);
 
-    matrix_t* input = matrix_t::from({a, b});
-    matrix_t* output = feed_forward(input)->clone();
+    /* Single samples go through the cache, if any. */
+    const bool cached = this->cache && inputs.cols == 1;
+    const u64 version = this->version;
+    matrix_t outputs;
 
-    this->data.map_if(!this->data.empty(), BASIC_UNARY_DELETE);
+    if(cached && this->cache->find(version, inputs.data.data(), inputs.rows, outputs))
+        return outputs;
 
-    /* Revert back to the networks old data state */
-    this->data = netdata;
+    outputs = forward_layer(0, inputs);
 
-    delete(input);
-    return output;
+    for(u64 i = 1; i < this->layers.size() - 1; i++)
+        outputs = forward_layer(i, outputs);
+
+    if(cached)
+        this->cache->insert(version, inputs.data.data(), inputs.rows, outputs);
+
+    return outputs;
 }
 
+/* Computes the activations of `layer` for a batch of inputs (one sample per column). */
 template<typename Float>
-void Network<Float>::save(std::string filename, i8 float_precision) const
+matrix_t Network<Float>::forward_layer(u64 layer, MatrixView<const Float> inputs) const
+{
+    matrix_t outputs = multiply(layer, inputs);
+    activate(this->activations[layer], outputs.data.data(), this->biases[layer].data.data(), outputs.rows, outputs.cols);
+
+    return outputs;
+}
+
+/* Applies the gradient step of `layer` given its `inputs`, its `outputs` and the `errors` of those outputs,
+ * and returns the errors of the inputs (empty for the first layer). With several columns the
+ * per-sample updates are summed into one step. */
+template<typename Float>
+matrix_t Network<Float>::backward_layer(u64 layer, MatrixView<const Float> inputs, const matrix_t& outputs,
+                                        const matrix_t& errors)
+{
+    matrix_t gradients = errors;
+    apply_derivative(this->activations[layer], outputs.data.data(), gradients.data.data(), gradients.data.size());
+
+    this->weights[layer].rank_update(this->learning_rate, gradients, inputs);
+
+    if(is_pruned(layer))
+        this->sparse[layer].mask(this->weights[layer]);
+
+    if(gradients.cols == 1)
+        this->biases[layer].add(gradients, this->learning_rate);
+    else
+    {
+        this->biases[layer].data.detach();
+
+        for(u64 r = 0; r < gradients.rows; r++)
+        {
+            Float sum = 0.0;
+
+            for(u64 c = 0; c < gradients.cols; c++)
+                sum += gradients.data[r * gradients.cols + c];
+
+            this->biases[layer].data[r] += this->learning_rate * sum;
+        }
+    }
+
+    /* Only after the update, so that a result computed from partly updated weights is never cached as the new version's. */
+    this->version.next();
+
+    return layer > 0 ? this->weights[layer].transpose_dot(errors) : matrix_t();
+}
+
+template<typename Float>
+matrix_t Network<Float>::test(Float a, Float b) const
+{
+    return predict(matrix_t::from({a, b}));
+}
+
+/* Removes every weight whose magnitude is at most `threshold`.
+ * Later calls to `train` fine-tune the remaining weights and keep the pruned ones at zero. */
+template<typename Float>
+void Network<Float>::prune(Float threshold)
+{
+    for(u64 i = 0; i < this->weights.size(); i++)
+        prune_layer(i, threshold);
+}
+
+/* Prunes the smallest-magnitude weights of each layer until
+ * `sparsity` (a fraction in [0, 1]) of them are zero. */
+template<typename Float>
+void Network<Float>::prune_to_sparsity(f64 sparsity)
+{
+    assert(sparsity >= 0.0 && sparsity <= 1.0);
+
+    for(u64 i = 0; i < this->weights.size(); i++)
+    {
+        cvector<Float> magnitudes = cvector<Float>::with_capacity(this->weights[i].data.size());
+
+        for(const Float& value : this->weights[i].data)
+            magnitudes.push_back(value < 0 ? -value : value);
+
+        u64 count = static_cast<u64>(sparsity * static_cast<f64>(magnitudes.size()));
+
+        if(count == 0)
+            continue;
+
+        std::nth_element(magnitudes.begin(), magnitudes.begin() + (count - 1), magnitudes.end());
+        prune_layer(i, magnitudes[count - 1]);
+    }
+}
+
+/* Gives the weights a new version, so that cached results of the current ones are no longer used. */
+template<typename Float>
+void Network<Float>::invalidate()
+{
+    this->version.next();
+}
+
+/* Packs the current weights and biases into an immutable inference-only model.
+ * Pruned layers are stored densely. */
+template<typename Float>
+InferenceModel<Float> Network<Float>::freeze() const
+{
+    std::shared_lock<SharedMutex> lock(this->guard);
+    InferenceModel<Float> model(this->layers, this->weights, this->biases, this->activations, this->accumulation);
+    model.kernels = this->kernels;
+
+    return model;
+}
+
+/* Returns a copy that shares the weights and biases of every layer with this network instead of copying them.
+ * Whichever network trains a layer first copies just that layer, so forking a large model for
+ * fine-tuning costs little more than the layers it ends up changing. */
+template<typename Float>
+Network<Float> Network<Float>::fork()
+{
+    std::unique_lock<SharedMutex> lock(this->guard);
+
+    for(u64 i = 0; i < this->weights.size(); i++)
+    {
+        this->weights[i].data.share();
+        this->biases[i].data.share();
+    }
+
+    return *this;
+}
+
+/* Picks the fastest matrix product settings for every layer at the given batch size (samples per call),
+ * timing them on this machine unless the tuner's cache already has them. */
+template<typename Float>
+void Network<Float>::tune(KernelTuner& tuner, u64 batch)
+{
+    this->kernels.resize(this->weights.size());
+
+    for(u64 i = 0; i < this->weights.size(); i++)
+        this->kernels[i] = tuner.tune<Float>(this->layers[i + 1], this->layers[i], batch, this->accumulation);
+}
+
+template<typename Float>
+void Network<Float>::save(std::string filename, i8 float_precision, SaveMode mode) const
 {
     ModelViewer<Float> viewer(std::move(filename), float_precision);
     Json::Value model;
 
-    model["d"] = viewer.jsonify(this->data);
+    std::shared_lock<SharedMutex> lock(this->guard);
+
+    if(mode == SaveMode::Full)
+        model["d"] = viewer.jsonify(this->data);
+
     model["b"] = viewer.jsonify(this->biases);
-    model["w"] = viewer.jsonify(this->weights);
+    model["w"] = viewer.jsonify(this->weights, this->sparse);
     model["l"] = viewer.jsonify(this->layers);
+    model["a"] = viewer.jsonify(this->activations);
 
     viewer.write(model);
 }
 
+/* Writes a binary model file with values in the `storage` format, which loads like any other model file. */
+template<typename Float>
+void Network<Float>::save(std::string filename, Storage storage, SaveMode mode, Encoding encoding) const
+{
+    ModelViewer<Float> viewer(std::move(filename));
+    std::shared_lock<SharedMutex> lock(this->guard);
+
+    viewer.write(snapshot(mode), storage, encoding);
+}
+
+/* Writes a compressed binary model file that only stores how the weights differ from those of the model file `base`,
+ * such as an earlier checkpoint of the same run. Loading it reads the base too, which must not change or move
+ * relative to the delta. */
+template<typename Float>
+void Network<Float>::save_delta(std::string filename, const std::string& base, Storage storage, SaveMode mode) const
+{
+    ModelViewer<Float> viewer(std::move(filename));
+    std::shared_lock<SharedMutex> lock(this->guard);
+
+    viewer.write(snapshot(mode), storage, Encoding::Compressed, base);
+}
+
+/* A copy of the parts of the network a binary model file stores. The caller holds the guard. */
+template<typename Float>
+Model<Float> Network<Float>::snapshot(SaveMode mode) const
+{
+    Model<Float> model;
+
+    if(mode == SaveMode::Full)
+        model.data = this->data;
+
+    model.layers = this->layers;
+    model.biases = this->biases;
+    model.weights = this->weights;
+    model.sparse = this->sparse;
+    model.activations = this->activations;
+
+    return model;
+}
+
+template<typename Float>
+void Network<Float>::prune_layer(u64 layer, Float threshold)
+{
+    this->sparse.resize(this->weights.size());
+    this->weights[layer].data.detach();
+
+    for(Float& value : this->weights[layer].data)
+        if((value < 0 ? -value : value) <= threshold)
+            value = 0.0;
+
+    this->sparse[layer] = SparseMatrix<Float>::from(this->weights[layer]);
+    this->version.next();
+}
+
+/* Multiplies by the weights of `layer`, using the sparse kernel when the layer is pruned enough. */
+template<typename Float>
+matrix_t Network<Float>::multiply(u64 layer, MatrixView<const Float> inputs) const
+{
+    if(is_pruned(layer) && this->sparse[layer].density() <= SPARSE_DENSITY_THRESHOLD)
+        return this->sparse[layer].dot(inputs);
+
+    return this->weights[layer].dot(inputs, this->accumulation,
+                                    layer < this->kernels.size() ? this->kernels[layer] : GemmConfig());
+}
+
+template<typename Float>
+bool Network<Float>::is_pruned(u64 layer) const
+{
+    return layer < this->sparse.size() && !this->sparse[layer].empty();
+}
+
 template<typename Float>
 void Network<Float>::assert_float_type()
 {
     if constexpr (!is_float_type<Float>)
     {
         std::cout << "[C++ Network]: Network<Float> requires Float to be a floating point type.\n";
-        std::cout << "\tSupported float types include: [f32 (float), f64 (double), and f128 (long double || __float128)]" << std::endl;
+        std::cout << "\tSupported float types include: [f32 (float), f64 (double), f128 (long double || __float128), and fdd (double-double)]" << std::endl;
         exit(EXIT_FAILURE);
     }
 }
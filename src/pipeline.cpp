@@ -0,0 +1,256 @@
+#include <xorai/pipeline.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#define matrix_t Matrix<Float>
+
+/* Micro-batches a queue can hold. Training keeps at most two per stage in flight,
+ * so with enough capacity no stage ever blocks on a full queue. */
+#define PIPELINE_QUEUE_CAPACITY 64
+
+/* Empty polls after which an idle stage starts sleeping instead of yielding. */
+#define PIPELINE_SPINS 1024
+
+static void wait_idle(u64& polls)
+{
+    if(++polls < PIPELINE_SPINS)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+/* Gathers samples [begin, end) of a dataset into the columns of a matrix. */
+template<typename Float>
+static matrix_t gather(const Dataset<Float>& samples, u64 begin, u64 end)
+{
+    matrix_t batch(samples[begin].size(), end - begin);
+
+    for(u64 j = 0; j < batch.cols; j++)
+        for(u64 r = 0; r < batch.rows; r++)
+            batch.data[r * batch.cols + j] = samples[begin + j][r];
+
+    return batch;
+}
+
+/* Splits the layers into `stages` contiguous groups holding roughly equal numbers of weights. */
+template<typename Float>
+Pipeline<Float>::Pipeline(Network<Float>& network, u64 stages, u64 micro_batch)
+    : micro_batch(std::max<u64>(micro_batch, 1)), network(network)
+{
+    const u64 count = network.weights.size();
+    u64 total = 0, sum = 0;
+
+    for(const matrix_t& weights : network.weights)
+        total += weights.data.size();
+
+    this->stages = std::clamp<u64>(stages, 1, count);
+    this->boundaries = {0};
+
+    for(u64 i = 0; i < count - 1 && this->boundaries.size() < this->stages; i++)
+    {
+        sum += network.weights[i].data.size();
+
+        u64 remaining = this->stages - this->boundaries.size();
+
+        if(sum * this->stages >= total * this->boundaries.size() || count - (i + 1) == remaining)
+            this->boundaries.push_back(i + 1);
+    }
+
+    this->boundaries.push_back(count);
+
+    const u64 capacity = std::max<u64>(PIPELINE_QUEUE_CAPACITY, 4 * this->stages);
+
+    for(u64 s = 0; s <= this->stages; s++)
+        this->forward_queues.push_back(std::make_unique<queue_t>(capacity));
+
+    for(u64 s = 0; s < this->stages; s++)
+        this->backward_queues.push_back(std::make_unique<queue_t>(capacity));
+
+    for(u64 s = 0; s < this->stages; s++)
+        this->threads.emplace_back(&Pipeline<Float>::stage_loop, this, s);
+}
+
+template<typename Float>
+Pipeline<Float>::~Pipeline()
+{
+    Message message {Kind::Stop, 0, {}, {}, {}};
+    send(*this->forward_queues[0], message);
+
+    for(std::thread& thread : this->threads)
+        thread.join();
+}
+
+/* Runs a batch (one sample per column) through the stages and returns the outputs in the same order. */
+template<typename Float>
+matrix_t Pipeline<Float>::predict(const matrix_t& inputs)
+{
+    assert(this->network.layers[0] == inputs.rows);
+
+    const u64 count = (inputs.cols + this->micro_batch - 1) / this->micro_batch;
+    matrix_t outputs(this->network.layers.back(), inputs.cols);
+
+    Message next, result;
+    u64 sent = 0, received = 0, polls = 0;
+
+    while(received < count)
+    {
+        if(sent < count && next.kind != Kind::Predict)
+        {
+            u64 begin = sent * this->micro_batch;
+            next = {Kind::Predict, sent, {}, {}, inputs.view().col_range(begin, std::min(inputs.cols - begin, this->micro_batch))};
+        }
+
+        if(sent < count && this->forward_queues[0]->push(next))
+        {
+            next.kind = Kind::Stop;
+            sent++;
+            polls = 0;
+        }
+        else if(this->forward_queues[this->stages]->pop(result))
+        {
+            u64 begin = result.id * this->micro_batch;
+
+            for(u64 r = 0; r < outputs.rows; r++)
+                std::copy_n(result.values.data.begin() + r * result.values.cols, result.values.cols,
+                            outputs.data.begin() + r * outputs.cols + begin);
+
+            received++;
+            polls = 0;
+        }
+        else
+            wait_idle(polls);
+    }
+
+    return outputs;
+}
+
+/* Trains on the dataset in micro-batches, with each micro-batch's per-sample updates summed into one step. */
+template<typename Float>
+void Pipeline<Float>::train(Dataset<Float>& inputs, Dataset<Float>& targets, u64 epochs)
+{
+    assert(inputs.size() == targets.size());
+
+    const u64 window = 2 * this->stages;
+    u64 in_flight = 0, polls = 0, id = 0;
+    Message message;
+
+    auto complete = [&]()
+    {
+        while(!this->backward_queues[0]->pop(message))
+            wait_idle(polls);
+
+        in_flight--;
+        polls = 0;
+    };
+
+    for(u64 i = 1; i < epochs + 1; i++)
+    {
+#if defined(DEBUG) && !defined(NO_DEBUG)
+        if((epochs < 100) || (i % (epochs / 100) == 0))
+            std::cout << "Epoch " << i << " of " << epochs << "\n";
+#endif
+        for(u64 begin = 0; begin < inputs.size(); begin += this->micro_batch)
+        {
+            u64 end = std::min<u64>(inputs.size(), begin + this->micro_batch);
+
+            if(in_flight == window)
+                complete();
+
+            message = {Kind::Train, id++, gather(inputs, begin, end), gather(targets, begin, end), {}};
+            send(*this->forward_queues[0], message);
+            in_flight++;
+        }
+    }
+
+    while(in_flight > 0)
+        complete();
+}
+
+/* Serves one stage until it receives `Stop`, always preferring backward work so that
+ * stashed activations are released as early as possible. */
+template<typename Float>
+void Pipeline<Float>::stage_loop(u64 stage)
+{
+    std::deque<MatrixArray<Float>> stash;
+    Message message;
+    u64 polls = 0;
+
+    while(true)
+    {
+        if(stage + 1 < this->stages && this->backward_queues[stage + 1]->pop(message))
+        {
+            backward(stage, std::move(message.values), stash.front());
+            stash.pop_front();
+            polls = 0;
+        }
+        else if(this->forward_queues[stage]->pop(message))
+        {
+            if(message.kind == Kind::Stop)
+            {
+                send(*this->forward_queues[stage + 1], message);
+                return;
+            }
+
+            forward(stage, message, stash);
+            polls = 0;
+        }
+        else
+            wait_idle(polls);
+    }
+}
+
+/* Runs a micro-batch through the stage's layers. Training micro-batches keep every activation
+ * of the stage for the backward pass, which the last stage starts right away. */
+template<typename Float>
+void Pipeline<Float>::forward(u64 stage, Message& message, std::deque<MatrixArray<Float>>& stash)
+{
+    const u64 first = this->boundaries[stage];
+
+    MatrixArray<Float> activations;
+    activations.push_back(std::move(message.values));
+
+    MatrixView<const Float> input = message.source.data ? message.source : activations.back().view();
+    message.source = {};
+
+    for(u64 i = first; i < this->boundaries[stage + 1]; i++)
+        activations.push_back(this->network.forward_layer(i, i == first ? input : activations.back().view()));
+
+    if(message.kind == Kind::Predict)
+    {
+        message.values = std::move(activations.back());
+        send(*this->forward_queues[stage + 1], message);
+    }
+    else if(stage + 1 == this->stages)
+        backward(stage, matrix_t(message.targets - activations.back()), activations);
+    else
+    {
+        message.values = activations.back();
+        send(*this->forward_queues[stage + 1], message);
+        stash.push_back(std::move(activations));
+    }
+}
+
+/* Updates the stage's layers from the errors of its outputs and passes the errors of its inputs back. */
+template<typename Float>
+void Pipeline<Float>::backward(u64 stage, matrix_t errors, const MatrixArray<Float>& activations)
+{
+    const u64 first = this->boundaries[stage];
+
+    for(u64 i = this->boundaries[stage + 1]; i-- > first;)
+        errors = this->network.backward_layer(i, activations[i - first], activations[i - first + 1], errors);
+
+    Message message {Kind::Backward, 0, std::move(errors), {}, {}};
+    send(*this->backward_queues[stage], message);
+}
+
+template<typename Float>
+void Pipeline<Float>::send(queue_t& queue, Message& message)
+{
+    u64 polls = 0;
+
+    while(!queue.push(message))
+        wait_idle(polls);
+}
+
+INSTANTIATE_CLASS_FLOATS(Pipeline)
@@ -0,0 +1,52 @@
+#include <xorai/registry.h>
+
+template<typename Float>
+std::mutex ModelRegistry<Float>::lock;
+
+template<typename Float>
+std::unordered_map<std::string, typename ModelRegistry<Float>::Entry> ModelRegistry<Float>::entries;
+
+/* Returns the shared network of a model file, loading it when no handle to its current version exists.
+ * Loads happen under the registry's lock, so concurrent opens of the same file parse it only once. */
+template<typename Float>
+typename ModelRegistry<Float>::handle_t ModelRegistry<Float>::open(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+
+    const std::string key = error ? path : canonical.string();
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(key, error);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    Entry& entry = entries[key];
+    handle_t network = entry.network.lock();
+
+    if(network && entry.modified == modified)
+        return network;
+
+    /* The registry's copy is a fork, so that networks copied from it share its layers. */
+    network = std::make_shared<const Network<Float>>(Network<Float>(key).fork());
+    entry = {modified, network};
+
+    std::erase_if(entries, [](const auto& item) { return item.second.network.expired(); });
+    return network;
+}
+
+/* A trainable copy of a registered model that shares its weights until it trains them. */
+template<typename Float>
+Network<Float> ModelRegistry<Float>::fork(const std::string& path)
+{
+    return *open(path);
+}
+
+/* Models currently held by at least one handle. */
+template<typename Float>
+u64 ModelRegistry<Float>::size()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    return std::count_if(entries.begin(), entries.end(), [](const auto& item) { return !item.second.network.expired(); });
+}
+
+INSTANTIATE_CLASS_FLOATS(ModelRegistry)
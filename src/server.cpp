@@ -0,0 +1,278 @@
+#include <xorai/server.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <cstring>
+
+/* Number of most recent request latencies kept for the percentile statistics. */
+#define LATENCY_SAMPLES 65536
+
+/* Requests claiming more values than this are treated as a protocol error and close the connection. */
+#define MAX_REQUEST_VALUES (1 << 24)
+
+template<typename Float>
+Server<Float>::Server(const Network<Float>& network, std::string path, u64 max_batch, u64 window)
+    : path(std::move(path)), max_batch(std::max<u64>(max_batch, 1)), window(window), network(network),
+      listener(-1), running(false), active_connections(0), latency_cursor(0), requests(0), batches(0)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if(this->path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "[C++ Server]: Socket path is too long: `" << this->path << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::strcpy(address.sun_path, this->path.c_str());
+    ::unlink(this->path.c_str());
+
+    this->listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(this->listener < 0
+        || ::bind(this->listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || ::listen(this->listener, SOMAXCONN) < 0)
+    {
+        std::cout << "[C++ Server]: Failed to listen on `" << this->path << "`\n";
+        std::cout << "[!] " << std::strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    /* Set here rather than in `run`, so that a `stop` before the runner thread gets going is not lost. */
+    this->running = true;
+}
+
+template<typename Float>
+Server<Float>::~Server()
+{
+    stop();
+
+    ::close(this->listener);
+    ::unlink(this->path.c_str());
+}
+
+/* Accepts connections until `stop` is called, returning at once if it already was. */
+template<typename Float>
+void Server<Float>::run()
+{
+    this->started = clock::now();
+
+    std::thread batcher(&Server<Float>::batch_loop, this);
+
+    while(this->running)
+    {
+        i32 fd = ::accept(this->listener, nullptr, nullptr);
+
+        if(fd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            break;
+        }
+
+        auto connection = std::make_shared<Connection>(fd);
+
+        std::lock_guard<std::mutex> lock(this->connections_lock);
+        std::erase_if(this->connections, [](const auto& weak) { return weak.expired(); });
+
+        this->connections.push_back(connection);
+        this->active_connections++;
+
+        std::thread(&Server<Float>::serve_connection, this, connection).detach();
+    }
+
+    this->running = false;
+    this->queue_ready.notify_all();
+    batcher.join();
+
+    std::unique_lock<std::mutex> lock(this->connections_lock);
+    this->connections_closed.wait(lock, [this] { return this->active_connections == 0; });
+}
+
+template<typename Float>
+void Server<Float>::stop()
+{
+    if(!this->running.exchange(false))
+        return;
+
+    ::shutdown(this->listener, SHUT_RDWR);
+
+    {
+        std::lock_guard<std::mutex> lock(this->connections_lock);
+
+        for(const std::weak_ptr<Connection>& weak : this->connections)
+            if(std::shared_ptr<Connection> connection = weak.lock())
+                ::shutdown(connection->fd, SHUT_RDWR);
+    }
+
+    this->queue_ready.notify_all();
+}
+
+template<typename Float>
+ServerStats Server<Float>::stats()
+{
+    std::lock_guard<std::mutex> lock(this->stats_lock);
+
+    ServerStats stats {};
+    cvector<f64> samples = this->latencies.clone();
+
+    stats.requests = static_cast<f64>(this->requests);
+    stats.batches = static_cast<f64>(this->batches);
+    stats.mean_batch = this->batches ? stats.requests / stats.batches : 0.0;
+
+    if(!samples.empty())
+    {
+        auto percentile = [&samples](f64 fraction)
+        {
+            auto it = samples.begin() + static_cast<i64>(fraction * static_cast<f64>(samples.size() - 1));
+            std::nth_element(samples.begin(), it, samples.end());
+            return *it;
+        };
+
+        stats.p50 = percentile(0.50);
+        stats.p99 = percentile(0.99);
+    }
+
+    f64 seconds = std::chrono::duration<f64>(clock::now() - this->started).count();
+    stats.throughput = seconds > 0.0 ? stats.requests / seconds : 0.0;
+
+    return stats;
+}
+
+template<typename Float>
+void Server<Float>::serve_connection(std::shared_ptr<Connection> connection)
+{
+    RequestHeader header {};
+    cvector<f64> values;
+
+    while(read_exact(connection->fd, &header, sizeof(header)))
+    {
+        if(header.count > MAX_REQUEST_VALUES)
+            break;
+
+        values.resize(header.count);
+
+        if(!read_exact(connection->fd, values.data(), header.count * sizeof(f64)))
+            break;
+
+        if(header.opcode == Opcode::Stats)
+        {
+            ServerStats current = stats();
+            respond(*connection, header.id, reinterpret_cast<const f64*>(&current), sizeof(current) / sizeof(f64));
+            continue;
+        }
+
+        /* An empty response tells the client that its input does not fit the network. */
+        if(header.opcode != Opcode::Infer || header.count != this->network.layers[0])
+        {
+            respond(*connection, header.id, nullptr, 0);
+            continue;
+        }
+
+        Request request {connection, header.id, cvector<Float>(values.begin(), values.end()), clock::now()};
+
+        {
+            std::lock_guard<std::mutex> lock(this->queue_lock);
+            this->queue.push_back(std::move(request));
+        }
+
+        this->queue_ready.notify_one();
+    }
+
+    ::shutdown(connection->fd, SHUT_RDWR);
+    connection.reset();
+
+    std::lock_guard<std::mutex> lock(this->connections_lock);
+    this->active_connections--;
+    this->connections_closed.notify_all();
+}
+
+/* Collects queued requests into batches and runs each batch through one forward pass. */
+template<typename Float>
+void Server<Float>::batch_loop()
+{
+    const u64 inputs = this->network.layers.front();
+    const u64 outputs = this->network.layers.back();
+
+    cvector<Request> batch;
+    cvector<f64> values(outputs);
+
+    while(true)
+    {
+        std::unique_lock<std::mutex> lock(this->queue_lock);
+        this->queue_ready.wait(lock, [this] { return !this->queue.empty() || !this->running; });
+
+        if(this->queue.empty())
+            break;
+
+        /* Give concurrent requests until `window` microseconds after the oldest one to join the batch. */
+        clock::time_point deadline = this->queue.front().arrival + std::chrono::microseconds(this->window);
+        this->queue_ready.wait_until(lock, deadline, [this] {
+            return this->queue.size() >= this->max_batch || !this->running;
+        });
+
+        u64 size = std::min<u64>(this->queue.size(), this->max_batch);
+
+        batch.clear();
+        std::move(this->queue.begin(), this->queue.begin() + static_cast<i64>(size), std::back_inserter(batch));
+        this->queue.erase(this->queue.begin(), this->queue.begin() + static_cast<i64>(size));
+
+        lock.unlock();
+
+        matrix_t samples(inputs, size);
+
+        for(u64 j = 0; j < size; j++)
+            for(u64 r = 0; r < inputs; r++)
+                samples.data[r * size + j] = batch[j].inputs[r];
+
+        matrix_t results = this->network.predict(std::move(samples));
+
+        for(u64 j = 0; j < size; j++)
+        {
+            for(u64 r = 0; r < outputs; r++)
+                values[r] = static_cast<f64>(results.data[r * size + j]);
+
+            respond(*batch[j].connection, batch[j].id, values.data(), outputs);
+        }
+
+        record(batch);
+    }
+}
+
+template<typename Float>
+void Server<Float>::respond(Connection& connection, u32 id, const f64* values, u32 count)
+{
+    ResponseHeader header {id, count};
+    cvector<u8> message(sizeof(header) + count * sizeof(f64));
+
+    std::memcpy(message.data(), &header, sizeof(header));
+
+    if(count > 0)
+        std::memcpy(message.data() + sizeof(header), values, count * sizeof(f64));
+
+    std::lock_guard<std::mutex> lock(connection.write_lock);
+    write_exact(connection.fd, message.data(), message.size());
+}
+
+template<typename Float>
+void Server<Float>::record(const cvector<Request>& batch)
+{
+    clock::time_point now = clock::now();
+    std::lock_guard<std::mutex> lock(this->stats_lock);
+
+    for(const Request& request : batch)
+    {
+        f64 latency = std::chrono::duration<f64, std::micro>(now - request.arrival).count();
+
+        if(this->latencies.size() < LATENCY_SAMPLES)
+            this->latencies.push_back(latency);
+        else
+            this->latencies[this->latency_cursor++ % LATENCY_SAMPLES] = latency;
+    }
+
+    this->requests += batch.size();
+    this->batches++;
+}
+
+INSTANTIATE_CLASS_FLOATS(Server)
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <xorai/sparse.h>
+#include <cassert>
+
+#define matrix_t Matrix<Float>
+#define sparse_t SparseMatrix<Float>
+
+template<typename Float>
+SparseMatrix<Float>::SparseMatrix()
+    : rows(0), cols(0), offsets({0}) {}
+
+template<typename Float>
+SparseMatrix<Float>::SparseMatrix(u64 rows, u64 cols, const cvector<u64>& offsets,
+                                  const cvector<u32>& indices, const cvector<Float>& values)
+    : rows(rows), cols(cols), offsets(offsets), indices(indices), values(values)
+{
+    assert(offsets.size() == rows + 1 && indices.size() == values.size());
+    assert(offsets.back() == values.size());
+}
+
+/* Sparse-dense product (a GEMV when `other` is a single column). */
+template<typename Float>
+matrix_t SparseMatrix<Float>::dot(MatrixView<const Float> other) const
+{
+    assert(this->cols == other.rows);
+
+    matrix_t result(this->rows, other.cols);
+    const u64 n = other.cols;
+    Float sum;
+
+    for(u64 i = 0; i < this->rows; i++)
+    {
+        if(n == 1)
+        {
+            sum = 0.0;
+
+            for(u64 p = this->offsets[i]; p < this->offsets[i + 1]; p++)
+                sum += this->values[p] * other(this->indices[p], 0);
+
+            result.data[i] = sum;
+            continue;
+        }
+
+        Float* output = result.data.data() + i * n;
+
+        for(u64 p = this->offsets[i]; p < this->offsets[i + 1]; p++)
+        {
+            const Float value = this->values[p];
+            const Float* input = other.row(this->indices[p]);
+
+            for(u64 j = 0; j < n; j++)
+                output[j] += value * input[j];
+        }
+    }
+
+    return result;
+}
+
+template<typename Float>
+matrix_t SparseMatrix<Float>::dense() const
+{
+    matrix_t result(this->rows, this->cols);
+
+    for(u64 i = 0; i < this->rows; i++)
+        for(u64 p = this->offsets[i]; p < this->offsets[i + 1]; p++)
+            result.data[i * this->cols + this->indices[p]] = this->values[p];
+
+    return result;
+}
+
+/* Zeroes every entry of `weights` outside the sparsity pattern
+ * and refreshes the stored values from the entries inside it. */
+template<typename Float>
+void SparseMatrix<Float>::mask(matrix_t& weights)
+{
+    assert(weights.rows == this->rows && weights.cols == this->cols);
+
+    weights.data.detach();
+
+    for(u64 i = 0; i < this->rows; i++)
+    {
+        Float* row = weights.data.data() + i * this->cols;
+        u64 p = this->offsets[i];
+
+        for(u64 j = 0; j < this->cols; j++)
+        {
+            if(p < this->offsets[i + 1] && this->indices[p] == j)
+                this->values[p++] = row[j];
+            else
+                row[j] = 0.0;
+        }
+    }
+}
+
+template<typename Float>
+sparse_t SparseMatrix<Float>::from(const matrix_t& matrix)
+{
+    sparse_t sparse;
+
+    sparse.rows = matrix.rows;
+    sparse.cols = matrix.cols;
+    sparse.offsets = cvector<u64>::with_capacity(matrix.rows + 1);
+    sparse.offsets.push_back(0);
+
+    for(u64 i = 0; i < matrix.rows; i++)
+    {
+        for(u64 j = 0; j < matrix.cols; j++)
+        {
+            const Float value = matrix.data[i * matrix.cols + j];
+
+            if(value != 0.0)
+            {
+                sparse.indices.push_back(static_cast<u32>(j));
+                sparse.values.push_back(value);
+            }
+        }
+
+        sparse.offsets.push_back(sparse.values.size());
+    }
+
+    return sparse;
+}
+
+template<typename Float>
+u64 SparseMatrix<Float>::nonzeros() const
+{
+    return this->values.size();
+}
+
+template<typename Float>
+f64 SparseMatrix<Float>::density() const
+{
+    return this->rows * this->cols != 0 ? static_cast<f64>(nonzeros()) / static_cast<f64>(this->rows * this->cols) : 1.0;
+}
+
+template<typename Float>
+bool SparseMatrix<Float>::empty() const
+{
+    return this->rows == 0;
+}
+
+INSTANTIATE_CLASS_FLOATS(SparseMatrix)
\ No newline at end of file
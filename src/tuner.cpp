@@ -0,0 +1,328 @@
+#include <jsoncpp/json/writer.h>
+#include <jsoncpp/json/reader.h>
+#include <xorai/tuner.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cmath>
+
+/* Each candidate is timed this many times, keeping the fastest. */
+#define TUNER_TRIALS 3
+
+/* A timing repeats the product until at least this many nanoseconds have passed. */
+#define TUNER_MIN_TIME 1000000.0
+
+template<typename Float>
+static const char* float_name()
+{
+    if constexpr (std::is_same_v<Float, f32>)
+        return "f32";
+    else if constexpr (std::is_same_v<Float, f64>)
+        return "f64";
+    else if constexpr (std::is_same_v<Float, fdd>)
+        return "fdd";
+    else
+        return "f128";
+}
+
+static const char* accumulation_name(Accumulation accumulation)
+{
+    switch(accumulation)
+    {
+        case Accumulation::Pairwise: return "pairwise";
+        case Accumulation::Kahan: return "kahan";
+        default: return "naive";
+    }
+}
+
+static Json::Value to_json(const GemmConfig& config, f64 nanoseconds)
+{
+    Json::Value object(Json::objectValue);
+
+    object["strategy"] = config.strategy == GemmStrategy::Blocked ? "blocked" : "inner";
+    object["lanes"] = Json::UInt64(config.lanes);
+    object["block_k"] = Json::UInt64(config.block_k);
+    object["block_j"] = Json::UInt64(config.block_j);
+    object["threads"] = Json::UInt64(config.threads);
+    object["ns"] = nanoseconds;
+
+    return object;
+}
+
+static GemmConfig from_json(const Json::Value& object)
+{
+    GemmConfig config;
+
+    config.strategy = object["strategy"].asString() == "blocked" ? GemmStrategy::Blocked : GemmStrategy::InnerProduct;
+    config.lanes = object.get("lanes", Json::UInt64(config.lanes)).asUInt64();
+    config.block_k = object.get("block_k", Json::UInt64(config.block_k)).asUInt64();
+    config.block_j = object.get("block_j", Json::UInt64(config.block_j)).asUInt64();
+    config.threads = std::max<u64>(object.get("threads", Json::UInt64(config.threads)).asUInt64(), 1);
+
+    return config;
+}
+
+/* Best time of one product in nanoseconds. Candidates whose first (cold) run already takes
+ * more than twice `fastest` are not timed any further. */
+template<typename Float>
+static f64 time_gemm(const cvector<Float>& a, const cvector<Float>& b, cvector<Float>& c,
+                     u64 rows, u64 inner, u64 cols, Accumulation accumulation, const GemmConfig& config, f64 fastest)
+{
+    using clock = std::chrono::steady_clock;
+    f64 best = HUGE_VAL;
+
+    clock::time_point cold = clock::now();
+    gemm(a.data(), b.data(), c.data(), rows, inner, cols, accumulation, config);
+
+    f64 first = std::chrono::duration<f64, std::nano>(clock::now() - cold).count();
+
+    if(first > 2.0 * fastest)
+        return first;
+
+    for(u64 trial = 0; trial < TUNER_TRIALS; trial++)
+    {
+        clock::time_point start = clock::now();
+        f64 elapsed;
+        u64 repetitions = 0;
+
+        do
+        {
+            gemm(a.data(), b.data(), c.data(), rows, inner, cols, accumulation, config);
+            repetitions++;
+            elapsed = std::chrono::duration<f64, std::nano>(clock::now() - start).count();
+        }
+        while(elapsed < TUNER_MIN_TIME);
+
+        best = std::min(best, elapsed / static_cast<f64>(repetitions));
+    }
+
+    return best;
+}
+
+KernelTuner::KernelTuner(std::string path)
+    : path(std::move(path)),
+      machine(cpu_model() + " (" + std::to_string(std::max(1u, std::thread::hardware_concurrency())) + " threads)"),
+      benchmarked(0)
+{
+    load();
+}
+
+/* Returns the fastest configuration for a `rows` x `inner` by `inner` x `cols` product,
+ * from the cache when this machine has tuned the shape before and by timing every candidate otherwise. */
+template<typename Float>
+GemmConfig KernelTuner::tune(u64 rows, u64 inner, u64 cols, Accumulation accumulation)
+{
+    const std::string shape = std::string(float_name<Float>()) + " " + std::to_string(rows) + "x" + std::to_string(inner)
+            + "x" + std::to_string(cols) + " " + accumulation_name(accumulation);
+
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    if(this->root.isMember(this->machine) && this->root[this->machine].isMember(shape))
+        return from_json(this->root[this->machine][shape]);
+
+    f64 nanoseconds = 0.0;
+    GemmConfig config = benchmark<Float>(rows, inner, cols, accumulation, nanoseconds);
+
+    this->root[this->machine][shape] = to_json(config, nanoseconds);
+    this->benchmarked++;
+    save();
+
+    return config;
+}
+
+/* Tries the inner-product kernel with every lane count and, for matrix-matrix products, the blocked
+ * kernel with a range of tile sizes, each on one thread and on all of them. */
+template<typename Float>
+GemmConfig KernelTuner::benchmark(u64 rows, u64 inner, u64 cols, Accumulation accumulation, f64& nanoseconds) const
+{
+    const bool naive = accumulation == Accumulation::Naive && !std::is_same_v<Float, fdd>;
+    const u64 hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    cvector<GemmConfig> candidates;
+
+    for(u64 threads : {static_cast<u64>(1), hardware})
+    {
+        if(threads > 1 && (hardware == 1 || rows == 1))
+            continue;
+
+        for(u64 lanes : {4, 8, 16})
+            if(naive || lanes == 8)
+                candidates.push_back({GemmStrategy::InnerProduct, lanes, 0, 0, threads});
+
+        if(!naive || cols == 1)
+            continue;
+
+        /* Tiles larger than the matrix all behave the same, so only the first of them is kept. */
+        for(u64 block_k : {16, 64, 256})
+            for(u64 block_j : {64, 256, 1024})
+                if((block_k == 16 || block_k / 4 < inner) && (block_j == 64 || block_j / 4 < cols))
+                    candidates.push_back({GemmStrategy::Blocked, 8, block_k, block_j, threads});
+    }
+
+    cvector<Float> a(rows * inner), b(inner * cols), c(rows * cols);
+
+    for(u64 k = 0; k < a.size(); k++)
+        a[k] = static_cast<f64>(k % 7) * 0.125;
+
+    for(u64 k = 0; k < b.size(); k++)
+        b[k] = static_cast<f64>(k % 5) * 0.25;
+
+    GemmConfig best = candidates[0];
+    nanoseconds = HUGE_VAL;
+
+    for(const GemmConfig& candidate : candidates)
+    {
+        f64 time = time_gemm(a, b, c, rows, inner, cols, accumulation, candidate, nanoseconds);
+
+        if(time < nanoseconds)
+        {
+            nanoseconds = time;
+            best = candidate;
+        }
+    }
+
+    return best;
+}
+
+/* `$XORAI_KERNEL_CACHE`, or `xorai/kernels.json` in the user's cache directory. */
+std::string KernelTuner::default_path()
+{
+    if(const char* path = std::getenv("XORAI_KERNEL_CACHE"))
+        return path;
+
+    if(const char* cache = std::getenv("XDG_CACHE_HOME"))
+        return std::string(cache) + "/xorai/kernels.json";
+
+    if(const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.cache/xorai/kernels.json";
+
+    return "xorai_kernels.json";
+}
+
+std::string KernelTuner::cpu_model()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+
+    while(std::getline(cpuinfo, line))
+    {
+        if(line.rfind("model name", 0) != 0)
+            continue;
+
+        u64 start = line.find(':');
+        start = start == std::string::npos ? line.size() : line.find_first_not_of(" \t", start + 1);
+
+        if(start != std::string::npos)
+            return line.substr(start);
+    }
+
+    return "unknown cpu";
+}
+
+/* A missing or unreadable cache only means that every shape gets tuned again. */
+void KernelTuner::load()
+{
+    this->root = read();
+}
+
+/* The cache file's contents, or an empty object when it is missing or malformed. */
+Json::Value KernelTuner::read() const
+{
+    Json::Value root(Json::objectValue);
+    std::ifstream file(this->path);
+
+    if(!file)
+        return root;
+
+    Json::CharReaderBuilder builder;
+    JSONCPP_STRING errors;
+
+    if(!Json::parseFromStream(builder, file, &root, &errors) || !root.isObject())
+    {
+        std::cout << "[C++ KernelTuner]: Ignoring malformed kernel cache: `" << this->path << "`" << std::endl;
+        return Json::Value(Json::objectValue);
+    }
+
+    return root;
+}
+
+/* Merges the shapes other runs saved since `load` into this tuner's and replaces the cache file.
+ * Savers take turns through an exclusive lock on `<path>.lock`, so none drops the shapes another one timed,
+ * and each writes its own temporary file and renames it over the cache, so readers never see a partial one. */
+void KernelTuner::save()
+{
+    std::error_code error;
+    std::filesystem::path target(this->path);
+
+    if(target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+
+    const i32 lock = ::open((this->path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if(lock >= 0)
+        ::flock(lock, LOCK_EX);
+
+    const Json::Value saved = read();
+
+    for(const std::string& machine : saved.getMemberNames())
+    {
+        if(!saved[machine].isObject())
+            continue;
+
+        for(const std::string& shape : saved[machine].getMemberNames())
+            if(!this->root[machine].isMember(shape))
+                this->root[machine][shape] = saved[machine][shape];
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+
+    const std::string contents = Json::writeString(builder, this->root) + "\n";
+    std::string temporary = this->path + ".XXXXXX";
+
+    const i32 file = ::mkstemp(temporary.data());
+    bool written = file >= 0 && ::fchmod(file, 0644) == 0;
+
+    for(u64 at = 0; written && at < contents.size();)
+    {
+        const ssize_t count = ::write(file, contents.data() + at, contents.size() - at);
+
+        if(count < 0 && errno == EINTR)
+            continue;
+
+        written = count > 0;
+        at += written ? static_cast<u64>(count) : 0;
+    }
+
+    if(file >= 0 && ::close(file) != 0)
+        written = false;
+
+    if(written)
+        std::filesystem::rename(temporary, target, error);
+    else
+    {
+        std::cout << "[C++ KernelTuner]: Failed to write the kernel cache: `" << this->path << "`" << std::endl;
+
+        if(file >= 0)
+            ::unlink(temporary.c_str());
+    }
+
+    if(lock >= 0)
+        ::close(lock);
+}
+
+#define INSTANTIATE_TUNER_FLOATS(Float) \
+    template GemmConfig KernelTuner::tune<Float>(u64, u64, u64, Accumulation);
+
+INSTANTIATE_TUNER_FLOATS(f32)
+INSTANTIATE_TUNER_FLOATS(f64)
+INSTANTIATE_TUNER_FLOATS(f128)
+INSTANTIATE_TUNER_FLOATS(fdd)
@@ -0,0 +1,78 @@
+#include <xorai/network.h>
+#include <unistd.h>
+#include <fstream>
+
+/* Trains, forks and queries a network wide enough that every matrix lives on the heap,
+ * and fails if the resident set size keeps growing once the allocator has warmed up.
+ * Also checks that random fills stay below their upper bound. */
+
+/* Returns the resident set size of this process in kilobytes. */
+static u64 resident_memory()
+{
+    std::ifstream statm("/proc/self/statm");
+    u64 pages = 0, resident = 0;
+
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* One round of everything that allocates: training (activations, gradients), copy-on-write forks
+ * that train their own copy of a layer, and predictions. */
+static void exercise(Network<f64>& network, Dataset<f64>& inputs, Dataset<f64>& targets, u64 epochs)
+{
+    network.train(inputs, targets, epochs);
+
+    for(u64 i = 0; i < epochs / 10; i++)
+    {
+        Network<f64> fork = network.fork();
+        fork.partial_fit(inputs[i % inputs.size()], targets[i % targets.size()]);
+
+        (void) network.test(1.0, 0.0);
+    }
+}
+
+/* Returns true if every element of a uniform fill lies in [low, high). Seed 207 draws a number that an
+ * `f32` rounds up to 1, so it catches fills that return `high`. */
+static bool in_range()
+{
+    const Matrix<f32> matrix = Matrix<f32>::random(256, 256, 207, 0, 0.0f, 1.0f);
+
+    for(f32 value : matrix.data)
+        if(value < 0.0f || value >= 1.0f)
+            return false;
+
+    return true;
+}
+
+int main()
+{
+    if(!in_range())
+    {
+        std::cout << "[!] A uniform fill returned its upper bound." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Dataset<f64> inputs = {{0.0, 0.0}, {0.0, 1.0}, {1.0, 0.0}, {1.0, 1.0}};
+    Dataset<f64> targets = {{1.0}, {0.0}, {0.0}, {1.0}};
+
+    /* 64 hidden units: well past the inline storage of `SmallBuffer`. */
+    Network<f64> network((U64Array){2, 64, 1}, 0.5, Initializer::Xavier, 1);
+
+    /* Warm up once so allocator caches and stream buffers are populated before measuring. */
+    exercise(network, inputs, targets, 10000);
+    std::cout << "Warm up: " << resident_memory() << " kB resident\n";
+
+    const u64 baseline = resident_memory();
+
+    for(u64 round = 1; round <= 5; round++)
+    {
+        exercise(network, inputs, targets, 10000);
+        std::cout << "Round " << round << ": " << resident_memory() << " kB resident\n";
+    }
+
+    /* Allow a page of jitter; a leak of one matrix per step grows by megabytes over the rounds. */
+    const bool flat = resident_memory() <= baseline + 4;
+    std::cout << (flat ? "[OK] Memory stayed flat." : "[!] Memory grew during training.") << std::endl;
+
+    return flat ? EXIT_SUCCESS : EXIT_FAILURE;
+}
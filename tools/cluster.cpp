@@ -0,0 +1,193 @@
+#include <xorai/distributed.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <cstring>
+#include <fstream>
+#include <chrono>
+
+/* Usage:
+ *   xorai_cluster server <model.xorai> <address> [options]
+ *   xorai_cluster worker <model.xorai> <address> <data> [options]
+ *   xorai_cluster local <model.xorai> <data> [options]
+ *
+ *   --workers <n>       Workers of the job (default: 2).
+ *   --staleness <s>     0 for synchronous steps, otherwise how many steps a worker may run ahead (default: 0).
+ *   --save <path>       Where the server saves the trained model (default: not saved).
+ *   --shard <i>         Which shard of the data this worker trains on, from 0 (default: 0).
+ *   --shards <n>        How many shards the data is split into (default: the number of workers).
+ *   --epochs <n>        Passes over the shard (default: 1).
+ *   --batch <n>         Samples per step (default: 1).
+ *
+ * The data file holds records of native-endian f64 inputs followed by targets, as read by
+ * `Network::partial_fit(fd)`. Worker `i` of `n` trains on records i, i + n, i + 2n, ...
+ * `local` runs the server and `--workers` worker processes on this machine over a Unix-domain socket. */
+
+struct Options
+{
+    std::string mode;
+    std::string model;
+    std::string address;
+    std::string data;
+    std::string save;
+    u64 workers = 2;
+    u64 staleness = 0;
+    u64 shard = 0;
+    u64 shards = 0;
+    u64 epochs = 1;
+    u64 batch = 1;
+};
+
+static void load_shard(const Options& options, const Network<f64>& network, Dataset<f64>& inputs, Dataset<f64>& targets)
+{
+    const u64 width = network.layers.front(), height = network.layers.back();
+    const u64 shards = options.shards ? options.shards : options.workers;
+
+    std::ifstream file(options.data, std::ios::binary);
+    cvector<f64> record(width + height);
+
+    if(!file)
+    {
+        std::cout << "[C++ Cluster]: Failed to open `" << options.data << "`" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for(u64 i = 0; file.read(reinterpret_cast<char*>(record.data()), record.size() * sizeof(f64)); i++)
+    {
+        if(i % shards != options.shard)
+            continue;
+
+        inputs.emplace_back(record.begin(), record.begin() + width);
+        targets.emplace_back(record.begin() + width, record.end());
+    }
+}
+
+static void run_server(const Options& options, Network<f64>& network, ParameterServer<f64>& server)
+{
+    auto started = std::chrono::steady_clock::now();
+    server.run();
+    f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - started).count();
+
+    std::cout << "Applied " << server.version << " updates from " << server.workers << " workers in "
+              << seconds << " s" << std::endl;
+
+    if(!options.save.empty())
+        network.save(options.save, UseMaxPrecision(64));
+}
+
+static void run_worker(const Options& options)
+{
+    Network<f64> network(options.model);
+    Dataset<f64> inputs, targets;
+
+    load_shard(options, network, inputs, targets);
+
+    Worker<f64> worker(network, options.address);
+    worker.train(inputs, targets, options.epochs, options.batch);
+
+    std::cout << "Worker " << options.shard << ": " << worker.steps << " steps over " << inputs.size()
+              << " samples" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    i32 positional = 0;
+
+    if(argc < 4)
+    {
+        std::cout << "Usage: " << argv[0] << " server <model.xorai> <address> [--workers n] [--staleness s] [--save path]\n"
+                  << "       " << argv[0] << " worker <model.xorai> <address> <data> [--workers n] [--shard i] [--shards n]"
+                  << " [--epochs n] [--batch n]\n"
+                  << "       " << argv[0] << " local <model.xorai> <data> [--workers n] [--staleness s] [--save path]"
+                  << " [--epochs n] [--batch n]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    options.mode = argv[1];
+    options.model = argv[2];
+
+    if(options.mode == "server")
+        options.address = argv[3], positional = 4;
+    else if(options.mode == "local")
+        options.data = argv[3], positional = 4;
+    else if(options.mode == "worker" && argc >= 5)
+        options.address = argv[3], options.data = argv[4], positional = 5;
+    else
+    {
+        std::cout << "[C++ Cluster]: Unknown mode `" << options.mode << "`" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for(int i = positional; i + 1 < argc; i += 2)
+    {
+        if(!std::strcmp(argv[i], "--workers"))
+            options.workers = std::max<u64>(std::stoull(argv[i + 1]), 1);
+        else if(!std::strcmp(argv[i], "--staleness"))
+            options.staleness = std::stoull(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--save"))
+            options.save = argv[i + 1];
+        else if(!std::strcmp(argv[i], "--shard"))
+            options.shard = std::stoull(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--shards"))
+            options.shards = std::stoull(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--epochs"))
+            options.epochs = std::stoull(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--batch"))
+            options.batch = std::stoull(argv[i + 1]);
+        else
+        {
+            std::cout << "[C++ Cluster]: Unknown option `" << argv[i] << "`" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(options.mode == "worker")
+    {
+        run_worker(options);
+        return EXIT_SUCCESS;
+    }
+
+    if(options.mode == "local")
+        options.address = "/tmp/xorai-cluster-" + std::to_string(::getpid()) + ".sock";
+
+    Network<f64> network(options.model);
+    ParameterServer<f64> server(network, options.address, options.workers, options.staleness);
+
+    if(options.mode == "server")
+    {
+        run_server(options, network, server);
+        return EXIT_SUCCESS;
+    }
+
+    /* The server is listening before the workers are forked, and no threads are running yet. */
+    cvector<pid_t> children;
+
+    for(u64 i = 0; i < options.workers; i++)
+    {
+        pid_t pid = ::fork();
+
+        if(pid == 0)
+        {
+            options.shard = i;
+            options.shards = options.workers;
+            run_worker(options);
+            std::cout.flush();
+            _exit(EXIT_SUCCESS);
+        }
+
+        children.push_back(pid);
+    }
+
+    run_server(options, network, server);
+
+    bool failed = false;
+
+    for(pid_t pid : children)
+    {
+        i32 status = 0;
+        ::waitpid(pid, &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+#include <xorai/model.h>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+/* Usage: xorai_codegen <model.xorai> <output.h> [options]
+ *   --name <identifier>     Namespace of the generated code (default: xorai_model).
+ *   --type <float|double>   Float type of the generated code (default: float).
+ *   --unroll <n>            Layers with at most n weights are fully unrolled, larger ones
+ *                           become loops over the constant arrays (default: 4096).
+ *
+ * The generated header only needs <cmath> and <cstddef>: the weights are `constexpr` arrays aligned
+ * to a cache line, and `forward` runs one sample through exactly this model's layers. */
+
+struct Options
+{
+    std::string model;
+    std::string output;
+    std::string name = "xorai_model";
+    std::string type = "float";
+    u64 unroll = 4096;
+};
+
+class Generator
+{
+public:
+    Generator(const Options& options, const Model<f64>& model) : options(options), model(model) {}
+
+    std::string generate()
+    {
+        const U64Array& layers = this->model.layers;
+
+        this->out << "// Generated by xorai_codegen from `" << this->options.model << "`. Do not edit.\n"
+                  << "#pragma once\n\n"
+                  << "#include <cmath>\n"
+                  << "#include <cstddef>\n\n"
+                  << "namespace " << this->options.name << "\n{\n\n"
+                  << "using real = " << this->options.type << ";\n\n"
+                  << "constexpr std::size_t inputs = " << layers.front() << ";\n"
+                  << "constexpr std::size_t outputs = " << layers.back() << ";\n";
+
+        for(u64 i = 0; i < layers.size() - 1; i++)
+            parameters(i);
+
+        activations();
+        forward();
+
+        this->out << "} // namespace " << this->options.name << "\n";
+        return this->out.str();
+    }
+
+private:
+    /* Scientific notation with enough digits to round-trip the generated type. */
+    std::string literal(f64 value) const
+    {
+        const bool single = this->options.type == "float";
+        std::ostringstream s;
+
+        if(std::isnan(value))
+            return "NAN";
+        if(std::isinf(value))
+            return value < 0 ? "-INFINITY" : "INFINITY";
+
+        s << std::scientific << std::setprecision(single ? 8 : 16) << value << (single ? "f" : "");
+        return s.str();
+    }
+
+    void parameters(u64 layer)
+    {
+        const Matrix<f64>& weights = this->model.weights[layer];
+        const Matrix<f64>& biases = this->model.biases[layer];
+
+        this->out << "\n// Layer " << layer << ": " << weights.cols << " -> " << weights.rows
+                  << " (" << activation_name(this->model.activations[layer]) << ")\n";
+
+        this->out << "alignas(64) constexpr real w" << layer << "[" << weights.rows << "][" << weights.cols << "] = {\n";
+
+        for(u64 r = 0; r < weights.rows; r++)
+        {
+            this->out << "    {";
+
+            for(u64 c = 0; c < weights.cols; c++)
+                this->out << (c ? ", " : "") << literal(weights.data[r * weights.cols + c]);
+
+            this->out << "},\n";
+        }
+
+        this->out << "};\n";
+        this->out << "alignas(64) constexpr real b" << layer << "[" << biases.rows << "] = {";
+
+        for(u64 r = 0; r < biases.rows; r++)
+            this->out << (r ? ", " : "") << literal(biases.data[r]);
+
+        this->out << "};\n";
+    }
+
+    /* Emits only the activation functions the model uses. */
+    void activations()
+    {
+        ActivationArray used = this->model.activations;
+        std::sort(used.begin(), used.end());
+        used.erase(std::unique(used.begin(), used.end()), used.end());
+
+        this->out << "\n";
+
+        for(Activation activation : used)
+        {
+            this->out << "inline real " << activation_name(activation) << "(real x) { return ";
+
+            switch(activation)
+            {
+                case Activation::Sigmoid: this->out << "real(1) / (real(1) + std::exp(-x))"; break;
+                case Activation::ReLU: this->out << "x > real(0) ? x : real(0)"; break;
+                case Activation::LeakyReLU: this->out << "x > real(0) ? x : x * " << literal(LEAKY_RELU_SLOPE); break;
+                case Activation::Tanh: this->out << "std::tanh(x)"; break;
+                case Activation::Identity: this->out << "x"; break;
+            }
+
+            this->out << "; }\n";
+        }
+    }
+
+    void forward()
+    {
+        const U64Array& layers = this->model.layers;
+        const u64 last = layers.size() - 2;
+
+        this->out << "\n/* Runs one sample of `inputs` values through the model and writes `outputs` values. */\n"
+                  << "inline void forward(const real* __restrict input, real* __restrict output)\n{\n";
+
+        for(u64 i = 0; i < last; i++)
+            this->out << "    alignas(64) real h" << i << "[" << layers[i + 1] << "];\n";
+
+        for(u64 i = 0; i <= last; i++)
+        {
+            std::string source = i == 0 ? "input" : "h" + std::to_string(i - 1);
+            std::string target = i == last ? "output" : "h" + std::to_string(i);
+
+            this->out << "\n";
+
+            if(this->model.weights[i].data.size() <= this->options.unroll)
+                unrolled(i, source, target);
+            else
+                looped(i, source, target);
+        }
+
+        this->out << "}\n\n";
+    }
+
+    /* One statement per neuron with constant indices, skipping pruned (zero) weights. */
+    void unrolled(u64 layer, const std::string& source, const std::string& target)
+    {
+        const Matrix<f64>& weights = this->model.weights[layer];
+        const char* activation = activation_name(this->model.activations[layer]);
+
+        for(u64 r = 0; r < weights.rows; r++)
+        {
+            this->out << "    " << target << "[" << r << "] = " << activation << "(b" << layer << "[" << r << "]";
+
+            for(u64 c = 0; c < weights.cols; c++)
+                if(weights.data[r * weights.cols + c] != 0.0)
+                    this->out << " + w" << layer << "[" << r << "][" << c << "] * " << source << "[" << c << "]";
+
+            this->out << ");\n";
+        }
+    }
+
+    void looped(u64 layer, const std::string& source, const std::string& target)
+    {
+        const Matrix<f64>& weights = this->model.weights[layer];
+
+        this->out << "    for(std::size_t r = 0; r < " << weights.rows << "; r++)\n"
+                  << "    {\n"
+                  << "        real sum = b" << layer << "[r];\n\n"
+                  << "        for(std::size_t c = 0; c < " << weights.cols << "; c++)\n"
+                  << "            sum += w" << layer << "[r][c] * " << source << "[c];\n\n"
+                  << "        " << target << "[r] = " << activation_name(this->model.activations[layer]) << "(sum);\n"
+                  << "    }\n";
+    }
+
+    const Options& options;
+    const Model<f64>& model;
+    std::ostringstream out;
+};
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if(argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <model.xorai> <output.h> [--name identifier] [--type float|double]"
+                  << " [--unroll n]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    options.model = argv[1];
+    options.output = argv[2];
+
+    for(int i = 3; i + 1 < argc; i += 2)
+    {
+        if(!std::strcmp(argv[i], "--name"))
+            options.name = argv[i + 1];
+        else if(!std::strcmp(argv[i], "--type"))
+            options.type = argv[i + 1];
+        else if(!std::strcmp(argv[i], "--unroll"))
+            options.unroll = std::stoull(argv[i + 1]);
+        else
+        {
+            std::cout << "[C++ Codegen]: Unknown option `" << argv[i] << "`" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(options.type != "float" && options.type != "double")
+    {
+        std::cout << "[C++ Codegen]: Unsupported type `" << options.type << "`" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ModelViewer<f64> viewer(options.model);
+    Model<f64> model = viewer.load(false);
+
+    std::ofstream file(options.output, std::ios::out | std::ios::trunc);
+    file << Generator(options, model).generate();
+
+    if(!file)
+    {
+        std::cout << "[C++ Codegen]: Failed to write `" << options.output << "`" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Generated `" << options.output << "` from `" << options.model << "`" << std::endl;
+    return EXIT_SUCCESS;
+}
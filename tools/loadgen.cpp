@@ -0,0 +1,114 @@
+#include <xorai/client.h>
+#include <xorai/random.h>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+/* Usage: xorai_loadgen <socket> [options]
+ *   --connections <n>   Concurrent closed-loop clients (default: 8).
+ *   --requests <n>      Requests sent by each client (default: 10000).
+ *   --inputs <n>        Values per request, matching the model's input layer (default: 2). */
+
+f64 percentile(cvector<f64>& samples, f64 fraction)
+{
+    if(samples.empty())
+        return 0.0;
+
+    auto it = samples.begin() + static_cast<i64>(fraction * static_cast<f64>(samples.size() - 1));
+    std::nth_element(samples.begin(), it, samples.end());
+    return *it;
+}
+
+int main(int argc, char** argv)
+{
+    using clock = std::chrono::steady_clock;
+
+    if(argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <socket> [--connections n] [--requests n] [--inputs n]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string socket = argv[1];
+    u64 connections = 8, requests = 10000, inputs = 2;
+
+    for(int i = 2; i + 1 < argc; i += 2)
+    {
+        u64 value = std::stoull(argv[i + 1]);
+
+        if(!std::strcmp(argv[i], "--connections"))
+            connections = value;
+        else if(!std::strcmp(argv[i], "--requests"))
+            requests = value;
+        else if(!std::strcmp(argv[i], "--inputs"))
+            inputs = value;
+        else
+        {
+            std::cout << "[C++ LoadGen]: Unknown option `" << argv[i] << "`" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(connections == 0 || requests == 0)
+    {
+        std::cout << "[C++ LoadGen]: Need at least one connection and one request per connection." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    cvector<cvector<f64>> latencies(connections);
+    cvector<std::thread> clients;
+    clock::time_point start = clock::now();
+
+    for(u64 c = 0; c < connections; c++)
+    {
+        clients.emplace_back([&, c]
+        {
+            Client client(socket);
+            Philox generator(c);
+            F64Array sample(inputs);
+
+            latencies[c].reserve(requests);
+
+            for(u64 r = 0; r < requests; r++)
+            {
+                for(u64 k = 0; k < inputs; k++)
+                    sample[k] = generator.uniform(r * inputs + k) < 0.5 ? 0.0 : 1.0;
+
+                clock::time_point sent = clock::now();
+
+                if(client.infer(sample).empty())
+                {
+                    std::cout << "[C++ LoadGen]: The server rejected a request, check `--inputs`." << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                latencies[c].push_back(std::chrono::duration<f64, std::micro>(clock::now() - sent).count());
+            }
+        });
+    }
+
+    for(std::thread& client : clients)
+        client.join();
+
+    f64 seconds = std::chrono::duration<f64>(clock::now() - start).count();
+    cvector<f64> samples;
+
+    for(const cvector<f64>& latency : latencies)
+        samples.insert(samples.end(), latency.begin(), latency.end());
+
+    std::cout << "Client:\trequests: " << samples.size()
+              << "\tp50: " << percentile(samples, 0.50) << " us"
+              << "\tp99: " << percentile(samples, 0.99) << " us"
+              << "\tthroughput: " << static_cast<f64>(samples.size()) / seconds << " req/s" << std::endl;
+
+    ServerStats stats = Client(socket).stats();
+
+    std::cout << "Server:\trequests: " << stats.requests
+              << "\tmean batch: " << stats.mean_batch
+              << "\tp50: " << stats.p50 << " us"
+              << "\tp99: " << stats.p99 << " us" << std::endl;
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
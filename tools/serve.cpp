@@ -0,0 +1,124 @@
+#include <xorai/server.h>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+
+/* Usage: xorai_serve <model.xorai> <socket> [options]
+ *   --precision <32|64|128|dd>  Float type used to load the model (default: 64).
+ *   --max-batch <n>             Largest number of requests per forward pass (default: 64).
+ *   --window-us <n>             How long a request may wait for others to join its batch (default: 200).
+ *   --report-s <n>              Seconds between statistics reports, 0 to disable (default: 5).
+ *   --tune <n>                  Tune the matrix kernels for batches of n requests, 0 to skip (default: 0).
+ *                               Tuned shapes are cached, so later starts on the same machine skip the timing. */
+
+struct Options
+{
+    std::string model;
+    std::string socket;
+    std::string precision = "64";
+    u64 max_batch = 64;
+    u64 window = 200;
+    u64 report = 5;
+    u64 tune = 0;
+};
+
+void report(const ServerStats& stats)
+{
+    std::cout << "requests: " << stats.requests
+              << "\tbatches: " << stats.batches
+              << "\tmean batch: " << stats.mean_batch
+              << "\tp50: " << stats.p50 << " us"
+              << "\tp99: " << stats.p99 << " us"
+              << "\tthroughput: " << stats.throughput << " req/s" << std::endl;
+}
+
+template<typename Float>
+int serve(const Options& options)
+{
+    /* Block the termination signals before any thread starts so that only `sigtimedwait` receives them. */
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Network<Float> network(options.model);
+
+    if(options.tune)
+    {
+        KernelTuner tuner;
+        network.tune(tuner, options.tune);
+
+        std::cout << "Tuned kernels for batches of " << options.tune << " (" << tuner.benchmarked
+                  << " new shapes, cache: `" << tuner.path << "`)" << std::endl;
+    }
+
+    Server<Float> server(network, options.socket, options.max_batch, options.window);
+    std::thread runner(&Server<Float>::run, &server);
+
+    std::cout << "Serving `" << options.model << "` on `" << options.socket << "`" << std::endl;
+
+    timespec interval {static_cast<time_t>(options.report ? options.report : 3600), 0};
+
+    while(sigtimedwait(&signals, nullptr, &interval) < 0)
+        if(errno == EAGAIN && options.report)
+            report(server.stats());
+
+    server.stop();
+    runner.join();
+    report(server.stats());
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if(argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <model.xorai> <socket> [--precision 32|64|128|dd]"
+                  << " [--max-batch n] [--window-us n] [--report-s n] [--tune n]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    options.model = argv[1];
+    options.socket = argv[2];
+
+    for(int i = 3; i + 1 < argc; i += 2)
+    {
+        if(!std::strcmp(argv[i], "--precision"))
+        {
+            options.precision = argv[i + 1];
+            continue;
+        }
+
+        u64 value = std::stoull(argv[i + 1]);
+
+        if(!std::strcmp(argv[i], "--max-batch"))
+            options.max_batch = value;
+        else if(!std::strcmp(argv[i], "--window-us"))
+            options.window = value;
+        else if(!std::strcmp(argv[i], "--report-s"))
+            options.report = value;
+        else if(!std::strcmp(argv[i], "--tune"))
+            options.tune = value;
+        else
+        {
+            std::cout << "[C++ Server]: Unknown option `" << argv[i] << "`" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(options.precision == "32")
+        return serve<f32>(options);
+    else if(options.precision == "64")
+        return serve<f64>(options);
+    else if(options.precision == "128")
+        return serve<f128>(options);
+    else if(options.precision == "dd")
+        return serve<fdd>(options);
+
+    std::cout << "[C++ Server]: Unsupported precision `" << options.precision << "`" << std::endl;
+    return EXIT_FAILURE;
+}
\ No newline at end of file